@@ -0,0 +1,146 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+#include <stdint.h>
+
+namespace ignis
+{
+
+/*
+ * Minimal benchmark runner in the spirit of Google Benchmark.
+ *
+ * A benchmark is a function which performs n iterations and returns the
+ * seconds spent in the timed part, so setup can be kept out of the
+ * measurement. The runner grows n until one run lasts minTime, then
+ * repeats the run and reports the median. Each iteration processes a
+ * fixed number of items (particles, events, values), and the time per
+ * item is what should be compared between builds.
+ */
+
+class BenchmarkSuite
+{
+public:
+
+    typedef std::function<double(const uint64_t nIterations)> Function;
+
+    BenchmarkSuite(const double minTime = 0.2, const uint nRepetitions = 5) :
+        m_minTime(minTime),
+        m_nRepetitions(nRepetitions)
+    {
+
+    }
+
+    void add(const std::string &name, const double itemsPerIteration, const std::string &unit, Function function)
+    {
+        m_benchmarks.push_back({name, itemsPerIteration, unit, function});
+    }
+
+    //! Runs the benchmarks whose names contain filter. Returns the number run.
+    uint run(const std::string &filter = "", const bool csv = false) const
+    {
+        using namespace std;
+
+        if (csv)
+        {
+            cout << "benchmark,iterations,ns_per_iteration,ns_per_item,unit,spread" << endl;
+        }
+
+        else
+        {
+            cout << left << setw(48) << "benchmark" << right
+                 << setw(12) << "iterations"
+                 << setw(16) << "ns/iteration"
+                 << setw(14) << "ns/item"
+                 << "  " << left << setw(10) << "item" << right
+                 << setw(10) << "spread" << endl;
+        }
+
+        uint nRun = 0;
+
+        for (const Benchmark &benchmark : m_benchmarks)
+        {
+            if (benchmark.m_name.find(filter) == std::string::npos)
+            {
+                continue;
+            }
+
+            uint64_t nIterations = 1;
+            double seconds = benchmark.m_function(nIterations);
+
+            while (seconds < m_minTime)
+            {
+                //Aim slightly past minTime, growing at most tenfold per step.
+                const double factor = seconds <= 0 ? 10 : std::min(10.0, 1.4*m_minTime/seconds);
+
+                nIterations = std::max(nIterations + 1, uint64_t(nIterations*factor));
+                seconds = benchmark.m_function(nIterations);
+            }
+
+            std::vector<double> times(1, seconds);
+
+            for (uint repetition = 1; repetition < m_nRepetitions; ++repetition)
+            {
+                times.push_back(benchmark.m_function(nIterations));
+            }
+
+            std::sort(times.begin(), times.end());
+
+            const double median = times[times.size()/2];
+            const double nsPerIteration = 1E9*median/nIterations;
+            const double nsPerItem = nsPerIteration/benchmark.m_itemsPerIteration;
+
+            //Relative spread between the fastest and slowest repetition.
+            const double spread = (times.back() - times.front())/median;
+
+            if (csv)
+            {
+                cout << benchmark.m_name << ","
+                     << nIterations << ","
+                     << nsPerIteration << ","
+                     << nsPerItem << ","
+                     << benchmark.m_unit << ","
+                     << spread << endl;
+            }
+
+            else
+            {
+                cout << left << setw(48) << benchmark.m_name << right
+                     << setw(12) << nIterations
+                     << setw(16) << fixed << setprecision(1) << nsPerIteration
+                     << setw(14) << setprecision(3) << nsPerItem
+                     << "  " << left << setw(10) << benchmark.m_unit << right
+                     << setw(9) << setprecision(1) << 100*spread << "%" << endl;
+
+                cout.unsetf(ios::fixed);
+            }
+
+            nRun++;
+        }
+
+        return nRun;
+    }
+
+private:
+
+    struct Benchmark
+    {
+        std::string m_name;
+        double m_itemsPerIteration;
+        std::string m_unit;
+        Function m_function;
+    };
+
+    const double m_minTime;
+
+    const uint m_nRepetitions;
+
+    std::vector<Benchmark> m_benchmarks;
+
+};
+
+}
@@ -0,0 +1,438 @@
+#include <ignis.h>
+
+#include "benchmark.h"
+
+#include "benchmarksetup.h"
+
+#include <chrono>
+#include <random>
+#include <cstring>
+#include <cstdio>
+
+using namespace ignis;
+using namespace std;
+
+/*
+ * Benchmarks of the event loop hot paths. Run as
+ *
+ *   ignisbenchmarks [filter] [--csv]
+ *
+ * to run the benchmarks whose names contain filter. Positions, triggers
+ * and stored values are generated from fixed seeds.
+ */
+
+typedef chrono::steady_clock Clock;
+
+static double secondsSince(const Clock::time_point start)
+{
+    return chrono::duration<double>(Clock::now() - start).count();
+}
+
+class Noop : public MeshEvent
+{
+public:
+
+    Noop() : MeshEvent("Noop") {}
+
+    void execute() {}
+};
+
+//! One iteration is a cycle in which only the particle handler runs.
+double updateContainments(const uint nParticles, const uint depth, const bool spatialIndex, const uint64_t nIterations)
+{
+    BenchmarkSystem system(nParticles, 10);
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh(benchmarkBox(0, 10));
+
+    mesh.enableOutput(false);
+    mesh.enableSpatialIndex(spatialIndex);
+
+    vector<MeshField<double>*> fields;
+    splitField(mesh, depth, fields);
+
+    const Clock::time_point start = Clock::now();
+
+    mesh.eventLoop(nIterations);
+
+    const double seconds = secondsSince(start);
+
+    for (uint i = fields.size(); i-- > 0;)
+    {
+        delete fields[i];
+    }
+
+    return seconds;
+}
+
+//! One iteration is a cycle executing nEvents trivial events.
+double executeEvents(const uint nEvents, const uint period, const uint64_t nIterations)
+{
+    BenchmarkSystem system(1, 10);
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh(benchmarkBox(0, 10));
+
+    mesh.enableOutput(false);
+
+    vector<Noop*> events(nEvents);
+
+    for (uint i = 0; i < nEvents; ++i)
+    {
+        events[i] = new Noop();
+        events[i]->setPeriod(period, i);
+
+        mesh.addEvent(events[i]);
+    }
+
+    const Clock::time_point start = Clock::now();
+
+    mesh.eventLoop(nIterations);
+
+    const double seconds = secondsSince(start);
+
+    for (uint i = nEvents; i-- > 0;)
+    {
+        mesh.removeEvent(events[i]);
+        delete events[i];
+    }
+
+    return seconds;
+}
+
+//! One iteration sorts and chunks nEvents events with random triggers.
+//! A single event spanning the loop stops it from initialize(), so
+//! eventLoop() returns right after the events are chunked.
+double setupChunks(const uint nEvents, const uint64_t nIterations)
+{
+    BenchmarkSystem system(1, 10);
+    Mesh::setCurrentParticles(system);
+
+    const uint nCycles = 2*nEvents;
+
+    double seconds = 0;
+
+    for (uint64_t iteration = 0; iteration < nIterations; ++iteration)
+    {
+        Mesh mesh(benchmarkBox(0, 10));
+
+        mesh.enableOutput(false);
+
+        BasicInitializeEvent<double> stopper("Stopper", [] (BasicInitializeEvent<double> *event)
+        {
+            event->stopLoop();
+        });
+
+        mesh.addEvent(stopper);
+
+        vector<Noop*> events(nEvents);
+
+        mt19937 generator(nEvents);
+        uniform_int_distribution<uint> cycle(0, nCycles - 1);
+
+        for (Noop *&event : events)
+        {
+            event = new Noop();
+            event->setTrigger(cycle(generator));
+
+            mesh.addEvent(event);
+        }
+
+        const Clock::time_point start = Clock::now();
+
+        mesh.eventLoop(nCycles);
+
+        seconds += secondsSince(start);
+
+        mesh.finalize();
+
+        for (uint i = nEvents; i-- > 0;)
+        {
+            mesh.removeEvent(events[i]);
+            delete events[i];
+        }
+
+        mesh.removeEvent(&stopper);
+    }
+
+    return seconds;
+}
+
+static const uint ignColumns = 8;
+
+static const string ignPath = "/tmp/ignis_benchmark.ign";
+
+//! Slowly varying values, as event values typically are.
+static double ignValue(const uint64_t row, const uint column)
+{
+    return (column + 1)*sin(1E-3*row) + 1E-2*column;
+}
+
+static double writeIgn(const uint64_t nRows, const uint compressionRows)
+{
+    const Clock::time_point start = Clock::now();
+
+    IgnWriter writer;
+
+    writer.setCompression(compressionRows);
+    writer.open(ignPath, ignColumns);
+
+    IgnHeader header;
+
+    for (uint j = 0; j < ignColumns; ++j)
+    {
+        header.m_columnNames.push_back("column" + to_string(j));
+        header.m_units.push_back("");
+    }
+
+    if (writer.compressed())
+    {
+        header.m_flags |= IgnHeader::Compressed;
+    }
+
+    const string headerBytes = header.serialize();
+
+    writer.writeRaw(headerBytes.c_str(), headerBytes.size());
+
+    for (uint64_t i = 0; i < nRows; ++i)
+    {
+        for (uint j = 0; j < ignColumns; ++j)
+        {
+            writer.write(ignValue(i, j));
+        }
+
+        writer.endRow();
+    }
+
+    writer.patch(IgnHeader::nRowsOffset, reinterpret_cast<const char*>(&nRows), sizeof(uint64_t));
+
+    if (writer.compressed())
+    {
+        const uint64_t indexOffset = writer.writeBlockIndex();
+
+        writer.patch(IgnHeader::indexOffsetOffset, reinterpret_cast<const char*>(&indexOffset), sizeof(uint64_t));
+    }
+
+    writer.close();
+
+    return secondsSince(start);
+}
+
+//! One iteration is a row of ignColumns values, including opening and closing the file.
+double ignWrite(const uint compressionRows, const uint64_t nIterations)
+{
+    const double seconds = writeIgn(nIterations, compressionRows);
+
+    remove(ignPath.c_str());
+
+    return seconds;
+}
+
+//! One iteration reads every column of a nRows row file.
+double ignRead(const uint64_t nRows, const uint compressionRows, const uint64_t nIterations)
+{
+    writeIgn(nRows, compressionRows);
+
+    double sum = 0;
+
+    const Clock::time_point start = Clock::now();
+
+    for (uint64_t iteration = 0; iteration < nIterations; ++iteration)
+    {
+        IgnReader reader(ignPath);
+
+        for (uint j = 0; j < reader.nCols(); ++j)
+        {
+            sum += accu(reader.column(j));
+        }
+    }
+
+    const double seconds = secondsSince(start);
+
+    remove(ignPath.c_str());
+
+    //Keeps the reads from being optimized away.
+    if (sum == 0.123456789)
+    {
+        cout << sum << endl;
+    }
+
+    return seconds;
+}
+
+//! One iteration wraps all particles. With crossing, every particle is
+//! first moved out of the box (untimed), so every one of them is wrapped.
+double wrapPeriodic(const uint nParticles, const bool crossing, const periodicScaling<double>::Wrap wrap, const uint64_t nIterations)
+{
+    BenchmarkSystem system(nParticles, 10);
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh(benchmarkBox(0, 10));
+
+    periodicScaling<double> scaling(wrap);
+    mesh.addEvent(scaling);
+
+    double seconds = 0;
+
+    Clock::time_point start = Clock::now();
+
+    for (uint64_t iteration = 0; iteration < nIterations; ++iteration)
+    {
+        if (crossing)
+        {
+            system.translate(10.5);
+            start = Clock::now();
+        }
+
+        scaling.execute();
+
+        if (crossing)
+        {
+            seconds += secondsSince(start);
+        }
+    }
+
+    if (!crossing)
+    {
+        seconds = secondsSince(start);
+    }
+
+    mesh.removeEvent(&scaling);
+
+    return seconds;
+}
+
+//! One iteration is a cycle placing every particle at a new random position.
+double shuffle(const uint nParticles, const uint64_t nIterations)
+{
+    BenchmarkSystem system(nParticles, 10);
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh(benchmarkBox(0, 10));
+
+    mesh.enableOutput(false);
+
+    randomShuffle<double> shuffle;
+    mesh.addEvent(shuffle);
+
+    const Clock::time_point start = Clock::now();
+
+    mesh.eventLoop(nIterations);
+
+    const double seconds = secondsSince(start);
+
+    mesh.removeEvent(&shuffle);
+
+    return seconds;
+}
+
+int main(int argc, char **argv)
+{
+    string filter = "";
+    bool csv = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(argv[i], "--csv") == 0)
+        {
+            csv = true;
+        }
+
+        else
+        {
+            filter = argv[i];
+        }
+    }
+
+    BenchmarkSuite suite;
+
+    for (const uint nParticles : {1000, 10000, 100000})
+    {
+        for (const uint depth : {1, 2, 3})
+        {
+            for (const bool spatialIndex : {false, true})
+            {
+                const string name = string("updateContainments/") + (spatialIndex ? "grid" : "tree")
+                        + "/N:" + to_string(nParticles) + "/depth:" + to_string(depth);
+
+                suite.add(name, nParticles, "particle", [=] (const uint64_t nIterations)
+                {
+                    return updateContainments(nParticles, depth, spatialIndex, nIterations);
+                });
+            }
+        }
+    }
+
+    for (const uint nEvents : {10, 100, 1000, 10000})
+    {
+        suite.add("executeEvents/every/events:" + to_string(nEvents), nEvents, "event", [=] (const uint64_t nIterations)
+        {
+            return executeEvents(nEvents, 1, nIterations);
+        });
+
+        //Every event is due one cycle out of ten.
+        suite.add("executeEvents/period:10/events:" + to_string(nEvents), nEvents/10.0, "event", [=] (const uint64_t nIterations)
+        {
+            return executeEvents(nEvents, 10, nIterations);
+        });
+    }
+
+    for (const uint nEvents : {1000, 10000, 100000})
+    {
+        suite.add("setupChunks/events:" + to_string(nEvents), nEvents, "event", [=] (const uint64_t nIterations)
+        {
+            return setupChunks(nEvents, nIterations);
+        });
+    }
+
+    for (const uint compressionRows : {0, 4096})
+    {
+        const string format = compressionRows == 0 ? "raw" : "compressed";
+
+        suite.add("ignWrite/" + format, ignColumns, "value", [=] (const uint64_t nIterations)
+        {
+            return ignWrite(compressionRows, nIterations);
+        });
+
+        const uint nRows = 1 << 16;
+
+        suite.add("ignRead/" + format + "/rows:" + to_string(nRows), nRows*ignColumns, "value", [=] (const uint64_t nIterations)
+        {
+            return ignRead(nRows, compressionRows, nIterations);
+        });
+    }
+
+    for (const uint nParticles : {1000, 100000})
+    {
+        for (const periodicScaling<double>::Wrap wrap : {periodicScaling<double>::Wrap::Floor, periodicScaling<double>::Wrap::Bounded})
+        {
+            for (const bool crossing : {false, true})
+            {
+                const string name = string("periodicScaling/")
+                        + (wrap == periodicScaling<double>::Wrap::Floor ? "floor/" : "bounded/")
+                        + (crossing ? "crossing" : "inside") + "/N:" + to_string(nParticles);
+
+                suite.add(name, nParticles, "particle", [=] (const uint64_t nIterations)
+                {
+                    return wrapPeriodic(nParticles, crossing, wrap, nIterations);
+                });
+            }
+        }
+    }
+
+    for (const uint nParticles : {1000, 1000000})
+    {
+        suite.add("randomShuffle/N:" + to_string(nParticles), nParticles, "particle", [=] (const uint64_t nIterations)
+        {
+            return shuffle(nParticles, nIterations);
+        });
+    }
+
+    if (suite.run(filter, csv) == 0)
+    {
+        cerr << "no benchmark matches " << filter << endl;
+        return 1;
+    }
+
+    return 0;
+}
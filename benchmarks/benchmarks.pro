@@ -0,0 +1,17 @@
+include(../defaults.pri)
+
+TEMPLATE = app
+CONFIG += console
+
+INCLUDEPATH  += $$TOP_PWD/include
+
+LIBS += -L../lib -lignis
+
+
+TARGET = ignisbenchmarks
+
+SOURCES = benchmarkmain.cpp
+
+HEADERS += \
+    benchmark.h \
+    benchmarksetup.h
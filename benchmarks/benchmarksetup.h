@@ -0,0 +1,106 @@
+#pragma once
+
+#include <ignis.h>
+
+#include <vector>
+#include <random>
+
+namespace ignis
+{
+
+//! N particles uniformly distributed in [0, length)^IGNIS_DIM, stored as
+//! struct-of-arrays. The seed is fixed so every run sees the same positions.
+class BenchmarkSystem : public PositionHandler<double>
+{
+public:
+
+    BenchmarkSystem(const uint count, const double length, const uint seed = 1) :
+        m_count(count),
+        m_data(count*IGNIS_DIM)
+    {
+        std::mt19937 generator(seed);
+        std::uniform_real_distribution<double> position(0, length);
+
+        for (double &x : m_data)
+        {
+            x = position(generator);
+        }
+    }
+
+    PositionSpan<double> span()
+    {
+        return PositionSpan<double>::SoA(m_data.data(), m_count);
+    }
+
+    virtual double operator() (const uint n, const uint d) const
+    {
+        return m_data[d*m_count + n];
+    }
+
+    virtual double &operator() (const uint n, const uint d)
+    {
+        return m_data[d*m_count + n];
+    }
+
+    uint count() const
+    {
+        return m_count;
+    }
+
+    //! Moves every particle by shift in all dimensions.
+    void translate(const double shift)
+    {
+        for (double &x : m_data)
+        {
+            x += shift;
+        }
+    }
+
+private:
+
+    const uint m_count;
+
+    std::vector<double> m_data;
+
+};
+
+inline mat benchmarkBox(const double low, const double high)
+{
+    mat topology(IGNIS_DIM, 2);
+
+    topology.col(0).fill(low);
+    topology.col(1).fill(high);
+
+    return topology;
+}
+
+//! Splits field in two along the first dimension, depth times recursively.
+//! The created fields are appended to fields, parents before children.
+inline void splitField(MeshField<double> &field, const uint depth, std::vector<MeshField<double>*> &fields)
+{
+    if (depth == 0)
+    {
+        return;
+    }
+
+    const double low = field.topology(0, 0);
+    const double middle = 0.5*(field.topology(0, 0) + field.topology(0, 1));
+    const double high = field.topology(0, 1);
+
+    for (const double start : {low, middle})
+    {
+        MeshField<double>::topmat topology = field.topology;
+
+        topology(0, 0) = start;
+        topology(0, 1) = start == low ? middle : high;
+
+        MeshField<double> *half = new MeshField<double>(topology, "half");
+
+        fields.push_back(half);
+        field.addSubField(*half);
+
+        splitField(*half, depth - 1, fields);
+    }
+}
+
+}
@@ -7,7 +7,9 @@ QMAKE_CXX = gcc
     QMAKE_CXX = ccache $$QMAKE_CXX
 }
 
-COMMON_CXXFLAGS = -std=c++11
+COMMON_CXXFLAGS = -std=c++11 -pthread
+
+QMAKE_LFLAGS += -pthread
 
 ### MPI Settings
 mpi {
@@ -20,15 +22,28 @@ mpi {
     COMMON_CXXFLAGS += $$system(mpicxx --showme:compile) -DMPICH_IGNORE_CXX_SEEK
 }
 
+### OpenMP Settings
+omp {
+    COMMON_CXXFLAGS += -fopenmp
+    QMAKE_LFLAGS += -fopenmp
+}
+
+### Vectorized kernels (AVX2/AVX-512) for the build machine
+native {
+    COMMON_CXXFLAGS += -march=native
+}
+
 QMAKE_CXXFLAGS += \
     $$COMMON_CXXFLAGS
 
 QMAKE_CXXFLAGS_DEBUG += \
     $$COMMON_CXXFLAGS
 
+#Lets comparisons and floor in loops (e.g. periodic wrapping) be vectorized.
 QMAKE_CXXFLAGS_RELEASE += \
     $$COMMON_CXXFLAGS \
     -O3 \
+    -fno-trapping-math \
     -DNDEBUG \
     -DARMA_NO_DEBUG
 
@@ -6,8 +6,8 @@
 namespace ignis
 {
 
-template<typename pT>
-class LauchDCViz : public Event<pT>
+template<typename pT, uint D = IGNIS_DIM>
+class LauchDCViz : public Event<pT, D>
 {
 
 public:
@@ -17,7 +17,7 @@ public:
                const bool dynamic = true,
                const int sx = 16,
                const int sy = 14) :
-        Event<pT>("DCViz"),
+        Event<pT, D>("DCViz"),
         m_delay(delay),
         m_viz(path),
         m_dynamic(dynamic),
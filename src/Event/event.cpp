@@ -2,30 +2,39 @@
 
 using namespace ignis;
 
-template<typename pT>
-Event<pT>::Event(std::string type, std::string unit, bool doOutput, bool toFile):
+template<typename pT, uint D>
+Event<pT, D>::Event(std::string type, std::string unit, bool doOutput, bool toFile):
     m_eventLength(IGNIS_UNSET_UINT),
     m_nCycles(IGNIS_UNSET_UINT),
     m_priority(IGNIS_UNSET_UINT),
     m_type(type),
-    m_value(new double(0)),
-    m_valueSetThisCycle(false),
+    m_value(&m_ownValue),
+    m_valueSetThisCycle(&m_ownValueSetThisCycle),
     m_hasOutput(doOutput),
     m_storeValue(toFile),
     m_unit(unit),
     m_meshField(nullptr),
-    m_cycle(IGNIS_UNSET_UINT),
+    m_cycleOrigin(IGNIS_UNSET_UINT),
     m_initialized(false),
     m_onsetTime(IGNIS_UNSET_UINT),
     m_offsetTime(IGNIS_UNSET_UINT),
-    m_registeredHandler(MainMesh<pT>::currentParticles()),
+    m_period(1),
+    m_phase(0),
+    m_registeredHandler(MainMesh<pT, D>::currentParticles()),
+    m_ownValue(0),
+    m_ownValueSetThisCycle(false),
+    m_resetFree(false),
+    m_accessDeclared(false),
+    m_reads(0),
+    m_writes(0),
+    m_profileSlot(IGNIS_UNSET_UINT),
     m_useDependancyCache(true)
 {
     m_refCounter++;
 }
 
-template<typename pT>
-Event<pT>::~Event()
+template<typename pT, uint D>
+Event<pT, D>::~Event()
 {
     m_refCounter--;
 
@@ -33,13 +42,36 @@ Event<pT>::~Event()
     {
         m_priorityCounter = 0;
     }
+}
+
+template<typename pT, uint D>
+void Event<pT, D>::_bindValue(double *value, bool *valueSetThisCycle)
+{
+    *value = *m_value;
+    *valueSetThisCycle = *m_valueSetThisCycle;
+
+    m_value = value;
+    m_valueSetThisCycle = valueSetThisCycle;
+}
+
+template<typename pT, uint D>
+void Event<pT, D>::_unbindValue()
+{
+    if (!_valueBound())
+    {
+        return;
+    }
 
-    delete m_value;
+    m_ownValue = *m_value;
+    m_ownValueSetThisCycle = *m_valueSetThisCycle;
+
+    m_value = &m_ownValue;
+    m_valueSetThisCycle = &m_ownValueSetThisCycle;
 }
 
 
-template<typename pT>
-void Event<pT>::_setPriority()
+template<typename pT, uint D>
+void Event<pT, D>::_setPriority()
 {
     if (m_priority == IGNIS_UNSET_UINT)
     {
@@ -47,8 +79,8 @@ void Event<pT>::_setPriority()
     }
 }
 
-template<typename pT>
-void Event<pT>::setManualPriority(uint p)
+template<typename pT, uint D>
+void Event<pT, D>::setManualPriority(uint p)
 {
     if (p == IGNIS_UNSET_UINT)
     {
@@ -62,8 +94,8 @@ void Event<pT>::setManualPriority(uint p)
     }
 }
 
-template<typename pT>
-void Event<pT>::_setExplicitTimes()
+template<typename pT, uint D>
+void Event<pT, D>::_setExplicitTimes()
 {
 
     BADAss(m_nCycles, !=, IGNIS_UNSET_UINT, "Unset number of cycles.");
@@ -87,8 +119,8 @@ void Event<pT>::_setExplicitTimes()
 }
 
 
-template<typename pT>
-std::string Event<pT>::dumpString()
+template<typename pT, uint D>
+std::string Event<pT, D>::dumpString()
 {
     using namespace std;
 
@@ -98,9 +130,9 @@ std::string Event<pT>::dumpString()
       << "<" << setw(20) << m_type << " "
       << "@" << setw(30) << m_meshField->description();
 
-    if (m_valueSetThisCycle){
+    if (*m_valueSetThisCycle){
         tail << "value: " << setprecision(3) << value() << " " << m_unit;
-        m_valueSetThisCycle = false;
+        *m_valueSetThisCycle = false;
     }
 
     tail << " >";
@@ -111,8 +143,8 @@ std::string Event<pT>::dumpString()
     return s.str();
 }
 
-template<typename pT>
-std::string Event<pT>::description() const
+template<typename pT, uint D>
+std::string Event<pT, D>::description() const
 {
     using namespace std;
 
@@ -133,12 +165,33 @@ std::string Event<pT>::description() const
     return s.str();
 }
 
+template<typename pT, uint D>
+void Event<pT, D>::_resolveDependencies()
+{
+    for (uint slot = 0; slot < m_dependencyTypes.size(); ++slot)
+    {
+        const auto &dependency = m_dependancies.find(m_dependencyTypes[slot]);
+
+        BADAss(dependency, !=, m_dependancies.end(), "Dependency not found.", [&] ()
+        {
+            BADAssSimpleDump(m_type, m_dependencyTypes[slot]);
+        });
+
+        BADAssBool(m_dependencyCheckers[slot](dependency->second), "Dependency does not match the type of its handle.", [&] ()
+        {
+            BADAssSimpleDump(m_type, m_dependencyTypes[slot]);
+        });
+
+        m_resolvedDependencies[slot] = dependency->second;
+    }
+}
+
 /*
    Static member variables:
 */
 
-template<typename pT>
-uint Event<pT>::m_refCounter = 0;
+template<typename pT, uint D>
+uint Event<pT, D>::m_refCounter = 0;
 
-template<typename pT>
-uint Event<pT>::m_priorityCounter = 0;
+template<typename pT, uint D>
+uint Event<pT, D>::m_priorityCounter = 0;
@@ -1,14 +1,17 @@
 #pragma once
 
 
-#include "../defines.h"
+#include "../forwards.h"
 
 #include "../MeshField/meshfield.h"
 
+#include "../Random/randomstream.h"
+
 #include <iostream>
 #include <iomanip>
 
 #include <map>
+#include <vector>
 
 #include "BADAss/badass.h"
 
@@ -18,10 +21,33 @@ using std::map;
 namespace ignis
 {
 
-template<typename pT>
-class PositionHandler;
+//! Typed reference to a dependency, returned by Event::setDependency. The
+//! dependency is looked up by type once when the loop starts, after which
+//! Event::dependency(handle) is an array access.
+template<typename T>
+class DependencyHandle
+{
+public:
+
+    DependencyHandle() : m_slot(IGNIS_UNSET_UINT) {}
+
+    bool valid() const
+    {
+        return m_slot != IGNIS_UNSET_UINT;
+    }
+
+private:
+
+    explicit DependencyHandle(const uint slot) : m_slot(slot) {}
+
+    uint m_slot;
+
+    template<typename pT, uint D>
+    friend class Event;
+
+};
 
-template<typename pT>
+template<typename pT, uint D>
 class Event
 {
 public:
@@ -44,7 +70,20 @@ public:
 
     virtual void initialize(){}
 
-    virtual void reset(){}
+    //! Called after all events of a cycle have executed.
+    virtual void reset() {}
+
+    //! Events with nothing to reset can leave the reset pass. Read when the
+    //! loop's execution plan is compiled, so set it before the loop starts.
+    void setResetFree(const bool state = true)
+    {
+        m_resetFree = state;
+    }
+
+    const bool &resetFree() const
+    {
+        return m_resetFree;
+    }
 
     uint meshAddress() const
     {
@@ -56,7 +95,12 @@ public:
         return m_nCycles;
     }
 
-    const MeshField<pT> &meshField() const
+    const MeshField<pT, D> &meshField() const
+    {
+        return *m_meshField;
+    }
+
+    MeshField<pT, D> &meshField()
     {
         return *m_meshField;
     }
@@ -66,9 +110,15 @@ public:
 
     void setManualPriority(uint p = IGNIS_UNSET_UINT);
 
-    const uint &cycle() const
+    //! Number of cycles since the event was initialized.
+    uint cycle() const
     {
-        return m_cycle;
+        if (m_cycleOrigin == IGNIS_UNSET_UINT)
+        {
+            return IGNIS_UNSET_UINT;
+        }
+
+        return *m_loopCycle - m_cycleOrigin;
     }
 
     const uint &priority() const
@@ -91,28 +141,60 @@ public:
         return m_type;
     }
 
-    void setDependency(const Event<pT> *event)
+    //! Setting a dependency of an already set type replaces it, also for
+    //! handles returned earlier.
+    template<typename T>
+    DependencyHandle<T> setDependency(const T *event)
     {
         BADAss(event, !=, nullptr, "null event dependency");
-        m_dependancies[event->type()] = event;
+
+        const string &type = event->type();
+
+        m_dependancies[type] = event;
+
+        uint slot = 0;
+
+        while (slot < m_dependencyTypes.size() && m_dependencyTypes[slot] != type)
+        {
+            slot++;
+        }
+
+        if (slot == m_dependencyTypes.size())
+        {
+            m_dependencyTypes.push_back(type);
+            m_resolvedDependencies.push_back(event);
+            m_dependencyCheckers.push_back(&_isA<T>);
+        }
+
+        else
+        {
+            m_resolvedDependencies[slot] = event;
+            m_dependencyCheckers[slot] = &_isA<T>;
+        }
+
+        return DependencyHandle<T>(slot);
     }
 
-    void setDependency(const Event<pT> &event)
+    template<typename T>
+    DependencyHandle<T> setDependency(const T &event)
     {
-        setDependency(&event);
+        return setDependency(&event);
     }
 
-    const map<const string, const Event<pT> *> &dependencies() const
+    //! Points the handles at the current dependency of their type. Called when the loop starts.
+    void _resolveDependencies();
+
+    const map<const string, const Event<pT, D> *> &dependencies() const
     {
         return m_dependancies;
     }
 
-    bool dependsOn(const Event<pT> *event, const bool recursive = true) const
+    bool dependsOn(const Event<pT, D> *event, const bool recursive = true) const
     {
 
         for (const auto &it: m_dependancies)
         {
-            const Event<pT> *dependency = it.second;
+            const Event<pT, D> *dependency = it.second;
 
             if (dependency == event)
             {
@@ -132,11 +214,57 @@ public:
 
     }
 
+    //! Declares the shared state (IGNIS_POSITIONS, IGNIS_CONTAINMENT, IGNIS_TOPOLOGY)
+    //! the event reads and writes besides its own value and those of its dependencies.
+    //! Undeclared events are never run concurrently with other events.
+    void declareAccess(const uint reads, const uint writes)
+    {
+        m_reads = reads;
+        m_writes = writes;
+        m_accessDeclared = true;
+    }
+
+    const bool &accessDeclared() const
+    {
+        return m_accessDeclared;
+    }
+
+    const uint &reads() const
+    {
+        return m_reads;
+    }
+
+    const uint &writes() const
+    {
+        return m_writes;
+    }
+
+    bool conflictsWith(const Event<pT, D> *event) const
+    {
+        if (!m_accessDeclared || !event->accessDeclared())
+        {
+            return true;
+        }
+
+        return (m_writes & (event->reads() | event->writes())) || (event->writes() & m_reads);
+    }
+
+    template<typename T>
+    const T *dependency(const DependencyHandle<T> &handle) const
+    {
+        BADAss(handle.m_slot, <, m_resolvedDependencies.size(), "Invalid dependency handle.");
+
+        return static_cast<const T*>(m_resolvedDependencies[handle.m_slot]);
+    }
+
     void disableDependancyCache()
     {
         m_useDependancyCache = false;
     }
 
+    //! Slow path looking up the dependency by type. Prefer the handle
+    //! returned by setDependency when calling this every cycle.
+
     template<typename T>
     const T *dependency(const string dependencyType)
     {
@@ -169,9 +297,9 @@ public:
         return static_cast<const T*>(loot->second);
     }
 
-    const Event<pT> *dependency(const string dependencyType)
+    const Event<pT, D> *dependency(const string dependencyType)
     {
-        return dependency<const Event<pT> >(dependencyType);
+        return dependency<const Event<pT, D> >(dependencyType);
     }
 
     const bool &storeValue() const
@@ -211,7 +339,7 @@ public:
 
     bool hasEnded() const
     {
-        return m_cycle > m_eventLength;
+        return cycle() > m_eventLength;
     }
 
     bool isActive() const
@@ -236,16 +364,16 @@ public:
 
     void setValue(double value)
     {
-        m_valueSetThisCycle = true;
+        *m_valueSetThisCycle = true;
         *(this->m_value) = value;
     }
 
     void setValue()
     {
-        m_valueSetThisCycle = true;
+        *m_valueSetThisCycle = true;
     }
 
-    void setMeshField(MeshField<pT> *meshField)
+    void setMeshField(MeshField<pT, D> *meshField)
     {
         this->m_meshField = meshField;
     }
@@ -267,7 +395,24 @@ public:
 
     void valueSetThisCycle(const bool state)
     {
-        m_valueSetThisCycle = state;
+        *m_valueSetThisCycle = state;
+    }
+
+    const bool &valueSetThisCycle() const
+    {
+        return *m_valueSetThisCycle;
+    }
+
+    //! Moves the value and its flag into slots owned by the main mesh for the
+    //! duration of a loop. The current value is carried over.
+    void _bindValue(double *value, bool *valueSetThisCycle);
+
+    //! Copies the value and its flag back into the event's own storage.
+    void _unbindValue();
+
+    bool _valueBound() const
+    {
+        return m_value != &m_ownValue;
     }
 
     void _setExplicitTimes();
@@ -295,20 +440,61 @@ public:
         m_offsetTime = IGNIS_UNSET_UINT;
     }
 
+    //! Execute only on loop cycles c with c%period == phase%period. The mesh
+    //! schedules these on a timing wheel, so off cycles cost nothing.
+    void setPeriod(const uint period, const uint phase = 0)
+    {
+        BADAss(period, !=, 0, "Zero period is not allowed.");
+
+        m_period = period;
+        m_phase = phase%period;
+    }
+
+    const uint &period() const
+    {
+        return m_period;
+    }
+
+    const uint &phase() const
+    {
+        return m_phase;
+    }
+
     void setTrigger(uint t)
     {
         setOnsetTime(t);
         setOffsetTime(t);
     }
 
-    void _zeroCycle()
+    //! The cycle count is derived from the loop cycle, so the mesh never iterates it per event.
+    void _zeroCycle(const uint loopCycle)
+    {
+        m_cycleOrigin = loopCycle;
+    }
+
+    //! Row of this event in the mesh's EventProfiler.
+    const uint &_profileSlot() const
+    {
+        return m_profileSlot;
+    }
+
+    void _setProfileSlot(const uint slot)
+    {
+        m_profileSlot = slot;
+    }
+
+    //! This event's stream, keyed by the main mesh seed and the event's position
+    //! in execution order (see MainMesh::setSeed).
+    //! Draw at indices derived from the work (cycle, particle, ...) to keep
+    //! parallel loops reproducible, or take a substream per work item.
+    const RandomStream &random() const
     {
-        m_cycle = 0;
+        return m_random;
     }
 
-    void _iterateCycle()
+    void _setRandomStream(const RandomStream &random)
     {
-        m_cycle++;
+        m_random = random;
     }
 
     const pT registeredHandler(const uint n, const uint d) const
@@ -321,7 +507,7 @@ public:
         return (*m_registeredHandler)(n, d);
     }
 
-    PositionHandler<pT> & registeredHandler() const
+    PositionHandler<pT, D> & registeredHandler() const
     {
         return *m_registeredHandler;
     }
@@ -365,7 +551,7 @@ protected:
 
     double* m_value;
 
-    bool m_valueSetThisCycle;
+    bool* m_valueSetThisCycle;
 
     const bool m_hasOutput;
 
@@ -374,9 +560,9 @@ protected:
     const string m_unit;
 
 
-    MeshField<pT> *m_meshField;
+    MeshField<pT, D> *m_meshField;
 
-    uint m_cycle;
+    uint m_cycleOrigin;
 
     bool m_initialized;
 
@@ -385,15 +571,44 @@ protected:
 
     uint m_offsetTime;
 
+    uint m_period;
+
+    uint m_phase;
+
 private:
 
-    PositionHandler<pT> *m_registeredHandler;
+    PositionHandler<pT, D> *m_registeredHandler;
+
+    //! Value storage used while the event is not bound to the main mesh.
+    double m_ownValue;
+    bool m_ownValueSetThisCycle;
+
+    map<const string, const Event<pT, D> *> m_dependancies;
+
+    //! Per handle slot: the dependency type, the event it resolved to, and a check of the handle's type.
+    std::vector<string> m_dependencyTypes;
+    std::vector<const Event<pT, D> *> m_resolvedDependencies;
+    std::vector<bool (*)(const Event<pT, D> *)> m_dependencyCheckers;
+
+    template<typename T>
+    static bool _isA(const Event<pT, D> *event)
+    {
+        return dynamic_cast<const T*>(event) != nullptr;
+    }
+
+    bool m_resetFree;
+
+    bool m_accessDeclared;
+    uint m_reads;
+    uint m_writes;
+
+    uint m_profileSlot;
 
-    map<const string, const Event<pT> *> m_dependancies;
+    RandomStream m_random;
 
     bool m_useDependancyCache;
     string m_dependancyCacheString;
-    const Event<pT> *m_cachedDependancy;
+    const Event<pT, D> *m_cachedDependancy;
 
 };
 
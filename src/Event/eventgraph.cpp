@@ -0,0 +1,121 @@
+#include "eventgraph.h"
+
+#include "event.h"
+
+#include "../Profiling/instrumentation.h"
+
+using namespace ignis;
+
+template<typename pT, uint D>
+EventGraph<pT, D>::EventGraph() :
+    m_parallel(false),
+    m_remaining(nullptr),
+    m_pool(nullptr),
+    m_due(nullptr),
+    m_instrumentation(nullptr)
+{
+    m_job = [this] (const uint task, const uint worker)
+    {
+        _runTask(task, worker);
+    };
+}
+
+template<typename pT, uint D>
+EventGraph<pT, D>::~EventGraph()
+{
+    delete [] m_remaining;
+}
+
+template<typename pT, uint D>
+void EventGraph<pT, D>::build(const std::vector<Event<pT, D> *> &events)
+{
+    const uint n = events.size();
+
+    m_events = events;
+
+    std::vector<std::vector<uint> > successors(n);
+
+    m_nPredecessors.assign(n, 0);
+
+    //Longest path from a root. Two events at the same level can run concurrently.
+    std::vector<uint> levels(n, 0);
+    std::vector<uint> levelWidths(n + 1, 0);
+
+    m_parallel = false;
+
+    for (uint j = 0; j < n; ++j)
+    {
+        for (uint i = 0; i < j; ++i)
+        {
+            if (events[j]->dependsOn(events[i], false) || events[i]->conflictsWith(events[j]))
+            {
+                successors[i].push_back(j);
+                m_nPredecessors[j]++;
+
+                levels[j] = std::max(levels[j], levels[i] + 1);
+            }
+        }
+
+        if (++levelWidths[levels[j]] > 1)
+        {
+            m_parallel = true;
+        }
+    }
+
+    m_firstSuccessor.assign(1, 0);
+    m_successors.clear();
+    m_roots.clear();
+
+    for (uint i = 0; i < n; ++i)
+    {
+        m_successors.insert(m_successors.end(), successors[i].begin(), successors[i].end());
+        m_firstSuccessor.push_back(m_successors.size());
+
+        if (m_nPredecessors[i] == 0)
+        {
+            m_roots.push_back(i);
+        }
+    }
+
+    delete [] m_remaining;
+    m_remaining = new std::atomic<uint>[n];
+}
+
+template<typename pT, uint D>
+void EventGraph<pT, D>::execute(WorkStealingPool &pool, const char *due)
+{
+    for (uint i = 0; i < m_events.size(); ++i)
+    {
+        m_remaining[i].store(m_nPredecessors[i], std::memory_order_relaxed);
+    }
+
+    m_pool = &pool;
+    m_due = due;
+
+    pool.run(m_roots, m_events.size(), m_job);
+}
+
+template<typename pT, uint D>
+void EventGraph<pT, D>::_runTask(const uint task, const uint worker)
+{
+    if (m_due[task] != 0)
+    {
+        if (m_instrumentation == nullptr)
+        {
+            m_events[task]->execute();
+        }
+
+        else
+        {
+            m_instrumentation->execute(m_events[task], worker);
+        }
+    }
+
+    for (const uint *successor = successorsBegin(task); successor != successorsEnd(task); ++successor)
+    {
+        if (m_remaining[*successor].fetch_sub(1) == 1)
+        {
+            m_pool->push(worker, *successor);
+        }
+    }
+}
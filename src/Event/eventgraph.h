@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../forwards.h"
+
+#include "workstealingpool.h"
+
+#include <vector>
+#include <atomic>
+
+namespace ignis
+{
+
+/*
+ * Dependency graph over the events of a loop chunk.
+ *
+ * An event must run after an earlier (in priority order) event if it
+ * depends on it, or if their declared accesses conflict (see
+ * Event::declareAccess). Events without declarations conflict with
+ * everything, so they act as barriers. Executing the graph on a pool
+ * therefore gives the same results as the serial order.
+ */
+
+template<typename pT, uint D>
+class EventGraph
+{
+public:
+
+    EventGraph();
+
+    ~EventGraph();
+
+    EventGraph(const EventGraph &) = delete;
+
+    EventGraph &operator = (const EventGraph &) = delete;
+
+    void build(const std::vector<Event<pT, D> *> &events);
+
+    //! False if the graph is a chain, in which case the events are best run serially.
+    bool parallel() const
+    {
+        return m_parallel;
+    }
+
+    const std::vector<uint> &roots() const
+    {
+        return m_roots;
+    }
+
+    //! Successors of event i are m_successors[m_firstSuccessor[i]...m_firstSuccessor[i + 1]).
+    const uint *successorsBegin(const uint i) const
+    {
+        return m_successors.data() + m_firstSuccessor[i];
+    }
+
+    const uint *successorsEnd(const uint i) const
+    {
+        return m_successors.data() + m_firstSuccessor[i + 1];
+    }
+
+    //! Events i with due[i] == 0 are skipped but still release their successors.
+    void execute(WorkStealingPool &pool, const char *due);
+
+    //! Profiles and traces every executed event on the worker running it. Null disables both.
+    void setInstrumentation(const Instrumentation<pT, D> *instrumentation)
+    {
+        m_instrumentation = instrumentation;
+    }
+
+private:
+
+    std::vector<Event<pT, D> *> m_events;
+
+    std::vector<uint> m_firstSuccessor;
+
+    std::vector<uint> m_successors;
+
+    std::vector<uint> m_nPredecessors;
+
+    std::vector<uint> m_roots;
+
+    bool m_parallel;
+
+
+    std::atomic<uint> *m_remaining;
+
+    WorkStealingPool *m_pool;
+
+    const char *m_due;
+
+    const Instrumentation<pT, D> *m_instrumentation;
+
+    WorkStealingPool::Job m_job;
+
+
+    void _runTask(const uint task, const uint worker);
+
+};
+
+}
+
+#include "eventgraph.cpp"
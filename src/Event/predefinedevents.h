@@ -6,10 +6,14 @@
 
 #include "../positionhandler.h"
 
+#include "../IO/ignreader.h"
+
 #include <fstream>
 #include <armadillo>
 
 #include <functional>
+#include <algorithm>
+#include <cmath>
 #include <assert.h>
 
 using std::function;
@@ -17,15 +21,15 @@ using std::function;
 namespace ignis
 {
 
-template<typename pT>
-class BasicExecuteEvent : public Event<pT>
+template<typename pT, uint D = IGNIS_DIM>
+class BasicExecuteEvent : public Event<pT, D>
 {
 public:
-    BasicExecuteEvent(std::string name, function<void(BasicExecuteEvent<pT>* event)> executeFunction) :
-        Event<pT>(name),
+    BasicExecuteEvent(std::string name, function<void(BasicExecuteEvent<pT, D>* event)> executeFunction) :
+        Event<pT, D>(name),
         m_executeFunction(executeFunction)
     {
-
+        this->setResetFree();
     }
 
     void execute()
@@ -34,19 +38,19 @@ public:
     }
 
 private:
-    const function<void(BasicExecuteEvent<pT>* event)> m_executeFunction;
+    const function<void(BasicExecuteEvent<pT, D>* event)> m_executeFunction;
 
 };
 
-template<typename pT>
-class BasicInitializeEvent : public Event<pT>
+template<typename pT, uint D = IGNIS_DIM>
+class BasicInitializeEvent : public Event<pT, D>
 {
 public:
-    BasicInitializeEvent(std::string name, function<void(BasicInitializeEvent<pT>* event)> initFunction) :
-        Event<pT>(name),
+    BasicInitializeEvent(std::string name, function<void(BasicInitializeEvent<pT, D>* event)> initFunction) :
+        Event<pT, D>(name),
         m_initFunction(initFunction)
     {
-
+        this->setResetFree();
     }
 
     void initialize()
@@ -60,39 +64,16 @@ public:
     }
 
 private:
-    const function<void(BasicInitializeEvent<pT>* event)> m_initFunction;
+    const function<void(BasicInitializeEvent<pT, D>* event)> m_initFunction;
 
 };
 
 
 inline void loadArmaFromIgn(arma::mat &matrix, const string path)
 {
-    using namespace std;
-    using namespace arma;
-
-    ifstream inFile;
-    inFile.open(path, ios::binary);
-
-    BADAssBool(inFile.good(), "Issues with opening file.", [&] ()
-    {
-        BADAssSimpleDump(path);
-    });
-
-    uint nRows, nCols;
-    inFile.read(reinterpret_cast<char*>(&nRows), sizeof(uint));
-    inFile.read(reinterpret_cast<char*>(&nCols), sizeof(uint));
+    IgnReader reader(path);
 
-    matrix.set_size(nRows, nCols);
-
-    for (uint l = 0; l < nRows; ++l)
-    {
-        for (uint m = 0; m < nCols; ++m)
-        {
-            inFile.read(reinterpret_cast<char*>(&matrix(l, m)), sizeof(double));
-        }
-    }
-
-    inFile.close();
+    matrix = reader.rows(0, reader.nRows());
 }
 
 
@@ -102,44 +83,202 @@ inline void loadArmaFromIgn(arma::mat &matrix, const string path)
  *
  */
 
-template<typename pT>
-class periodicScaling : public Event<pT> {
+/*
+ * Periodic boundaries: wraps positions back into the box of the event's field.
+ *
+ * Wrap::Floor works for any displacement, x -= L*floor((x - origin)/L).
+ * Wrap::Bounded assumes no particle moved more than a box length since the
+ * last wrap, and replaces the floor with a single conditional add or
+ * subtract. Both are branchless, and run as plain loops over contiguous
+ * positions so that the compiler can vectorize them.
+ *
+ * With face tracking enabled, the containment update lists the particles
+ * within margin of a face (or outside the box), and only those are wrapped.
+ * margin must bound how far particles move between the containment update
+ * and the wrap. The list is private to the event, so the field tree is left
+ * untouched.
+ */
+
+template<typename pT, uint D = IGNIS_DIM>
+class periodicScaling : public Event<pT, D> {
 public:
 
-    using Event<pT>::registeredHandler;
-    using Event<pT>::m_meshField;
+    using Event<pT, D>::registeredHandler;
+    using Event<pT, D>::m_meshField;
+
+    enum class Wrap
+    {
+        Floor,
+        Bounded
+    };
+
+    periodicScaling(const Wrap wrap = Wrap::Floor) :
+        Event<pT, D>("PeriodicRescale"),
+        m_wrap(wrap),
+        m_tracksFaces(false)
+    {
+        this->declareAccess(IGNIS_POSITIONS | IGNIS_TOPOLOGY, IGNIS_POSITIONS);
+        this->setResetFree();
+    }
+
+    ~periodicScaling()
+    {
+        disableFaceTracking();
+    }
+
+    //! The event must be added to its field first.
+    void enableFaceTracking(const pT margin)
+    {
+        BADAssBool(m_meshField != nullptr, "Add the event to its field before enabling face tracking.");
 
-    periodicScaling() : Event<pT>("PeriodicRescale") {}
+        disableFaceTracking();
 
+        m_meshField->mainMesh()->_trackFaces(m_meshField, margin, &m_nearFace);
+        m_tracksFaces = true;
+
+        this->declareAccess(IGNIS_POSITIONS | IGNIS_TOPOLOGY | IGNIS_CONTAINMENT, IGNIS_POSITIONS);
+    }
+
+    void disableFaceTracking()
+    {
+        if (!m_tracksFaces)
+        {
+            return;
+        }
+
+        m_meshField->mainMesh()->_untrackFaces(&m_nearFace);
+        m_nearFace.clear();
+        m_tracksFaces = false;
+
+        this->declareAccess(IGNIS_POSITIONS | IGNIS_TOPOLOGY, IGNIS_POSITIONS);
+    }
+
+    bool tracksFaces() const
+    {
+        return m_tracksFaces;
+    }
+
+    //! The particles wrapped by the next execute() with face tracking.
+    const std::vector<uint> &nearFace() const
+    {
+        return m_nearFace;
+    }
 
-    //Hey, what I mean to say is that I rescale all positions to fit the mesh _if_ they are set to
-    //periodic. If not, you have to add an event to take care of collisions with walls.
     void execute()
     {
+        const PositionSpan<pT, D> positions = registeredHandler().span();
 
-        using namespace std;
+        if (m_tracksFaces)
+        {
+            _wrapNearFaces(positions);
+            return;
+        }
 
-        for (uint i = 0; i < registeredHandler().count(); ++i) {
-            if (registeredHandler()(i, 0) < m_meshField->topology(0, 0)) {
-                registeredHandler()(i, 0) += m_meshField->shape(0);
+        const uint n = registeredHandler().count();
+
+        if (!positions.valid())
+        {
+            for (uint i = 0; i < n; ++i)
+            {
+                for (uint d = 0; d < D; ++d)
+                {
+                    _wrap(registeredHandler()(i, d), d);
+                }
             }
-            registeredHandler()(i, 0) = m_meshField->topology(0, 0) +
-                    fmod(registeredHandler()(i, 0) - m_meshField->topology(0, 0), m_meshField->shape(0));
 
-            if (registeredHandler()(i, 1) < m_meshField->topology(1, 0)) {
-                registeredHandler()(i, 1) += m_meshField->shape(1);
+            return;
+        }
+
+        for (uint d = 0; d < D; ++d)
+        {
+            const pT origin = m_meshField->topology(d, 0);
+            const pT length = m_meshField->shape(d);
+            const double inverseLength = 1.0/length;
+
+            pT *x = &positions(0, d);
+            const uint stride = positions.particleStride;
+
+            //Unit stride (SoA) is split out so it vectorizes.
+            if (m_wrap == Wrap::Bounded)
+            {
+                if (stride == 1)
+                {
+                    for (uint i = 0; i < n; ++i)
+                    {
+                        x[i] = wrapBounded(x[i], origin, length);
+                    }
+                }
+
+                else
+                {
+                    for (uint i = 0; i < n; ++i)
+                    {
+                        x[i*stride] = wrapBounded(x[i*stride], origin, length);
+                    }
+                }
             }
-            registeredHandler()(i, 1) = m_meshField->topology(1, 0) +
-                    fmod(registeredHandler()(i, 1) - m_meshField->topology(1, 0), m_meshField->shape(1));
 
-#if IGNIS_DIM == 3
-            if (registeredHandler()(i, 2) < m_meshField->topology(2, 0)) {
-                registeredHandler()(i, 2) += m_meshField->shape(2);
+            else
+            {
+                if (stride == 1)
+                {
+                    for (uint i = 0; i < n; ++i)
+                    {
+                        x[i] = wrapFloor(x[i], origin, length, inverseLength);
+                    }
+                }
+
+                else
+                {
+                    for (uint i = 0; i < n; ++i)
+                    {
+                        x[i*stride] = wrapFloor(x[i*stride], origin, length, inverseLength);
+                    }
+                }
             }
-            registeredHandler()(i, 2) = m_meshField->topology(2, 0) +
-                    fmod(registeredHandler()(i, 2), m_meshField->shape(2));
+        }
+    }
 
-#endif
+    static pT wrapFloor(const pT x, const pT origin, const pT length, const double inverseLength)
+    {
+        return x - length*static_cast<pT>(std::floor((x - origin)*inverseLength));
+    }
+
+    //! Exact if x is less than a box length outside the box.
+    static pT wrapBounded(const pT x, const pT origin, const pT length)
+    {
+        return x + (x < origin ? length : pT(0)) - (x >= origin + length ? length : pT(0));
+    }
+
+private:
+
+    const Wrap m_wrap;
+
+    bool m_tracksFaces;
+
+    std::vector<uint> m_nearFace;
+
+    void _wrap(pT &x, const uint d) const
+    {
+        const pT origin = m_meshField->topology(d, 0);
+        const pT length = m_meshField->shape(d);
+
+        x = m_wrap == Wrap::Bounded ? wrapBounded(x, origin, length) : wrapFloor(x, origin, length, 1.0/length);
+    }
+
+    void _wrapParticle(const PositionSpan<pT, D> &positions, const uint i) const
+    {
+        for (uint d = 0; d < D; ++d)
+        {
+            _wrap(positions.valid() ? positions(i, d) : registeredHandler()(i, d), d);
+        }
+    }
+
+    void _wrapNearFaces(const PositionSpan<pT, D> &positions) const
+    {
+        for (const uint i : m_nearFace)
+        {
+            _wrapParticle(positions, i);
         }
     }
 
@@ -154,20 +293,69 @@ public:
  */
 
 
-template<typename pT>
-class randomShuffle : public Event<pT> {
+template<typename pT, uint D = IGNIS_DIM>
+class randomShuffle : public Event<pT, D> {
 public:
-    randomShuffle() : Event<pT>("shuffling") {}
+    randomShuffle() : Event<pT, D>("shuffling"), m_nThreads(1)
+    {
+        this->declareAccess(IGNIS_TOPOLOGY, IGNIS_POSITIONS);
+        this->setResetFree();
+    }
+
+    //! Contiguous positions are filled in blocks on nThreads OpenMP threads.
+    //! The positions do not depend on the number of threads.
+    void setThreads(const uint nThreads)
+    {
+        BADAss(nThreads, !=, 0);
+
+        m_nThreads = nThreads;
+    }
 
     void execute() {
 
-        for (uint i = 0; i < Event<pT>::registeredHandler().count(); ++i) {
-            for (uint j = 0; j < IGNIS_DIM; ++j) {
-                Event<pT>::registeredHandler()(j, i) = Event<pT>::m_meshField->topology(j, 0) + (pT)(drand48()*Event<pT>::m_meshField->shape(j));
+        const PositionSpan<pT, D> positions = Event<pT, D>::registeredHandler().span();
+
+        const RandomStream &random = this->random();
+
+        const uint n = Event<pT, D>::registeredHandler().count();
+
+        for (uint d = 0; d < D; ++d) {
+
+            const pT low = Event<pT, D>::m_meshField->topology(d, 0);
+            const pT high = Event<pT, D>::m_meshField->topology(d, 1);
+
+            //Value i of the stream goes to particle i, whichever thread draws it.
+            const uint64_t first = (uint64_t(this->loopCycle())*D + d)*n;
+
+            if (!positions.valid()) {
+                for (uint i = 0; i < n; ++i) {
+                    random.fillUniform(&Event<pT, D>::registeredHandler()(i, d), first + i, 1, low, high);
+                }
+
+                continue;
+            }
+
+            pT *x = &positions(0, d);
+            const uint stride = positions.particleStride;
+
+            const uint blockSize = 4096;
+            const uint nBlocks = (n + blockSize - 1)/blockSize;
+
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(m_nThreads) schedule(static)
+#endif
+            for (uint block = 0; block < nBlocks; ++block) {
+                const uint start = block*blockSize;
+
+                random.fillUniform(x + start*stride, first + start, std::min(blockSize, n - start), low, high, stride);
             }
         }
     }
 
+private:
+
+    uint m_nThreads;
+
 };
 
 
@@ -180,40 +368,48 @@ public:
  */
 
 
-template<typename pT>
-class countAtoms : public Event<pT>
+template<typename pT, uint D = IGNIS_DIM>
+class countAtoms : public Event<pT, D>
 {
 public:
 
-    countAtoms() : Event<pT>("Counting atoms", "", true) {}
+    countAtoms() : Event<pT, D>("Counting atoms", "", true)
+    {
+        this->declareAccess(IGNIS_CONTAINMENT, 0);
+        this->setResetFree();
+    }
 
     void execute()
     {
-        this->setValue(Event<pT>::m_meshField->getPopulation()/double(Event<pT>::registeredHandler().count()));
+        this->setValue(Event<pT, D>::m_meshField->getPopulation()/double(Event<pT, D>::registeredHandler().count()));
     }
 
 };
 
 
-template<typename pT>
-class VolumeChange : public Event <pT>
+template<typename pT, uint D = IGNIS_DIM>
+class VolumeChange : public Event<pT, D>
 {
 public:
 
     VolumeChange(double ratio, bool recursive) :
-        Event<pT>("VolumeChange"),
+        Event<pT, D>("VolumeChange"),
         ratio(ratio),
         recursive(recursive)
     {
         assert(ratio > 0 && "RATIO CANOT BE NEGATIVE");
+
+        this->declareAccess(IGNIS_CONTAINMENT | IGNIS_POSITIONS | IGNIS_TOPOLOGY, IGNIS_POSITIONS | IGNIS_TOPOLOGY);
+        this->setResetFree();
     }
 
     void initialize() {
 
-        topology0 = Event<pT>::m_meshField->topology;
-        volume0   = Event<pT>::m_meshField->volume;
+        topology0 = Event<pT, D>::m_meshField->topology;
+        volume0   = Event<pT, D>::m_meshField->volume;
 
-        k = (pow(ratio, 1.0/IGNIS_DIM) - 1)/Event<pT>::m_eventLength;
+        //The event runs m_eventLength + 1 cycles, the last one reaching the full ratio.
+        k = (pow(ratio, 1.0/D) - 1)/(Event<pT, D>::m_eventLength + 1);
 
     }
 
@@ -231,51 +427,49 @@ private:
 protected:
     void execute() {
 
-        double vPrev = Event<pT>::m_meshField->volume;
+        double vPrev = Event<pT, D>::m_meshField->volume;
         assert(vPrev != 0 && "Can't increase volume of empty volume.(V=0)");
 
-        double dL = k*(Event<pT>::m_cycle + 1.0);
+        double dL = k*(Event<pT, D>::cycle() + 1.0);
         Mat<pT> newTopology = topology0*(1 + dL);
 
-        Event<pT>::m_meshField->setTopology(newTopology, recursive);
+        Event<pT, D>::m_meshField->setTopology(newTopology, recursive);
 
-        pT vNew = Event<pT>::m_meshField->volume;
+        pT vNew = Event<pT, D>::m_meshField->volume;
         assert(vNew != 0 && "Volume changed to zero");
 
-        pT scale = (pT)pow(vNew/(double)vPrev, 1.0/IGNIS_DIM);
-        for (const uint & i : Event<pT>::m_meshField->getAtoms()) {
-            Event<pT>::registeredHandler().vec(i) *= scale;
+        pT scale = (pT)pow(vNew/(double)vPrev, 1.0/D);
+        for (const uint & i : Event<pT, D>::m_meshField->getAtoms()) {
+            Event<pT, D>::registeredHandler().vec(i) *= scale;
         }
     }
 
 };
 
 
-template<typename pT>
-class SaveToFile : public Event<pT> {
+template<typename pT, uint D = IGNIS_DIM>
+class SaveToFile : public Event<pT, D> {
 public:
 
-    SaveToFile(std::string path, uint freq) : Event<pT>("SaveData"), path(path), freq(freq) {}
+    SaveToFile(std::string path, uint freq) : Event<pT, D>("SaveData"), path(path)
+    {
+        this->setPeriod(freq);
+    }
 
     void execute()
     {
-        if ((Event<pT>::loopCycle() % freq) == 0)
-        {
-
-            scaledPos = Event<pT>::registeredHandler();
-            scaledPos.col(0)/=Event<pT>::m_meshField->shape(0);
-            scaledPos.col(1)/=Event<pT>::m_meshField->shape(1);
+        scaledPos = Event<pT, D>::registeredHandler();
+        scaledPos.col(0)/=Event<pT, D>::m_meshField->shape(0);
+        scaledPos.col(1)/=Event<pT, D>::m_meshField->shape(1);
 
-            std::stringstream s;
-            s << path << "/ignisPos" << Event<pT>::loopCycle() << ".arma";
-            scaledPos.save(s.str());
-        }
+        std::stringstream s;
+        s << path << "/ignisPos" << Event<pT, D>::loopCycle() << ".arma";
+        scaledPos.save(s.str());
     }
 
 private:
 
     std::string path;
-    uint freq;
 
     Mat<pT> scaledPos;
 
@@ -314,7 +508,10 @@ private:
 class density : public Event<> {
 public:
 
-    density() : Event<>("Density", "", true, true) {}
+    density() : Event<>("Density", "", true, true)
+    {
+        declareAccess(IGNIS_CONTAINMENT | IGNIS_TOPOLOGY, 0);
+    }
 
     void execute() {
         setValue(m_meshField->getPopulation()/(double)m_meshField->volume);
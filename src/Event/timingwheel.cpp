@@ -0,0 +1,63 @@
+#include "timingwheel.h"
+
+#include <BADAss/badass.h>
+
+using namespace ignis;
+
+inline void TimingWheel::reset(const uint nSlots)
+{
+    BADAss(nSlots, !=, 0);
+
+    uint size = 1;
+
+    while (size < nSlots)
+    {
+        size *= 2;
+    }
+
+    m_slots.resize(size);
+
+    for (std::vector<Entry> &slot : m_slots)
+    {
+        slot.clear();
+    }
+
+    m_mask = size - 1;
+    m_size = 0;
+}
+
+inline void TimingWheel::schedule(const uint cycle, const uint id)
+{
+    BADAssBool(!m_slots.empty(), "Timing wheel is not reset.");
+
+    m_slots[cycle & m_mask].push_back({cycle, id});
+    m_size++;
+}
+
+inline void TimingWheel::advance(const uint cycle, std::vector<uint> &due)
+{
+    if (m_size == 0)
+    {
+        return;
+    }
+
+    std::vector<Entry> &slot = m_slots[cycle & m_mask];
+
+    for (uint i = 0; i < slot.size();)
+    {
+        if (slot[i].m_cycle == cycle)
+        {
+            due.push_back(slot[i].m_id);
+
+            slot[i] = slot.back();
+            slot.pop_back();
+
+            m_size--;
+        }
+
+        else
+        {
+            ++i;
+        }
+    }
+}
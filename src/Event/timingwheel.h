@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../defines.h"
+
+#include <vector>
+
+namespace ignis
+{
+
+/*
+ * Hashed timing wheel for periodic events.
+ *
+ * Entries are (due cycle, id) pairs stored in slot due%nSlots. Advancing
+ * to a cycle only inspects that cycle's slot, so idle cycles cost a single
+ * lookup however many entries are waiting. Entries due more than nSlots
+ * cycles ahead simply stay in their slot until their cycle comes around.
+ */
+
+class TimingWheel
+{
+public:
+
+    TimingWheel() :
+        m_mask(0),
+        m_size(0)
+    {
+
+    }
+
+    //! nSlots is rounded up to a power of two.
+    void reset(const uint nSlots);
+
+    bool empty() const
+    {
+        return m_size == 0;
+    }
+
+    void schedule(const uint cycle, const uint id);
+
+    //! Removes the entries due at cycle and appends their ids to due.
+    void advance(const uint cycle, std::vector<uint> &due);
+
+private:
+
+    struct Entry
+    {
+        uint m_cycle;
+        uint m_id;
+    };
+
+    std::vector<std::vector<Entry> > m_slots;
+
+    uint m_mask;
+
+    uint m_size;
+
+};
+
+}
+
+#include "timingwheel.cpp"
@@ -0,0 +1,172 @@
+#include "workstealingpool.h"
+
+#include <BADAss/badass.h>
+
+using namespace ignis;
+
+inline WorkStealingPool::WorkStealingPool(const uint nThreads) :
+    m_nThreads(nThreads),
+    m_queues(new Queue[nThreads]),
+    m_job(nullptr),
+    m_nTasks(0),
+    m_nCompleted(0),
+    m_nBusy(0),
+    m_generation(0),
+    m_stopThreads(false)
+{
+    BADAss(nThreads, !=, 0, "At least one thread is required.");
+
+    for (uint worker = 1; worker < nThreads; ++worker)
+    {
+        m_threads.push_back(std::thread(&WorkStealingPool::_threadLoop, this, worker));
+    }
+}
+
+inline WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopThreads = true;
+    }
+
+    m_started.notify_all();
+
+    for (std::thread &thread : m_threads)
+    {
+        thread.join();
+    }
+
+    delete [] m_queues;
+}
+
+inline void WorkStealingPool::run(const std::vector<uint> &roots, const uint nTasks, const Job &job)
+{
+    if (nTasks == 0)
+    {
+        return;
+    }
+
+    m_job = &job;
+    m_nTasks = nTasks;
+    m_nCompleted = 0;
+
+    for (uint i = 0; i < roots.size(); ++i)
+    {
+        push(i%m_nThreads, roots[i]);
+    }
+
+    m_nBusy = m_nThreads - 1;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_generation++;
+    }
+
+    m_started.notify_all();
+
+    _work(0);
+
+    //Workers may still be leaving _work() and must not see the next batch early.
+    while (m_nBusy.load() != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    m_job = nullptr;
+}
+
+inline void WorkStealingPool::push(const uint worker, const uint task)
+{
+    Queue &queue = m_queues[worker];
+
+    std::lock_guard<std::mutex> lock(queue.m_mutex);
+    queue.m_tasks.push_back(task);
+}
+
+inline void WorkStealingPool::_work(const uint worker)
+{
+    uint task;
+
+    while (m_nCompleted.load() != m_nTasks)
+    {
+        if (_pop(worker, task) || _steal(worker, task))
+        {
+            (*m_job)(task, worker);
+            m_nCompleted++;
+        }
+
+        else
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+inline bool WorkStealingPool::_pop(const uint worker, uint &task)
+{
+    Queue &queue = m_queues[worker];
+
+    std::lock_guard<std::mutex> lock(queue.m_mutex);
+
+    if (queue.m_tasks.empty())
+    {
+        return false;
+    }
+
+    task = queue.m_tasks.back();
+    queue.m_tasks.pop_back();
+
+    return true;
+}
+
+inline bool WorkStealingPool::_steal(const uint worker, uint &task)
+{
+    for (uint k = 1; k < m_nThreads; ++k)
+    {
+        Queue &victim = m_queues[(worker + k)%m_nThreads];
+
+        std::lock_guard<std::mutex> lock(victim.m_mutex);
+
+        if (!victim.m_tasks.empty())
+        {
+            task = victim.m_tasks.front();
+            victim.m_tasks.pop_front();
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline void WorkStealingPool::_threadLoop(const uint worker)
+{
+    const uint nSpins = 1000;
+
+    uint generation = 0;
+
+    while (true)
+    {
+        for (uint spin = 0; spin < nSpins && m_generation.load() == generation; ++spin)
+        {
+            std::this_thread::yield();
+        }
+
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_started.wait(lock, [&] () {return m_generation.load() != generation || m_stopThreads;});
+
+            if (m_stopThreads)
+            {
+                return;
+            }
+
+            generation = m_generation.load();
+        }
+
+        _work(worker);
+
+        m_nBusy--;
+    }
+}
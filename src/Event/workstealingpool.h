@@ -0,0 +1,96 @@
+#pragma once
+
+#include "../defines.h"
+
+#include <vector>
+#include <deque>
+#include <functional>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+namespace ignis
+{
+
+/*
+ * Thread pool running batches of dependent tasks.
+ *
+ * run() hands out the root tasks and returns once nTasks tasks have
+ * completed. Jobs make successors available by calling push() with their
+ * own worker index. Each worker pops from the back of its own queue and
+ * steals from the front of the others when it runs dry. The calling thread
+ * is worker 0, so a pool of n threads starts n - 1 threads. Between batches
+ * the workers spin briefly before going to sleep.
+ */
+
+class WorkStealingPool
+{
+public:
+
+    typedef std::function<void(const uint task, const uint worker)> Job;
+
+    WorkStealingPool(const uint nThreads);
+
+    ~WorkStealingPool();
+
+    WorkStealingPool(const WorkStealingPool &) = delete;
+
+    WorkStealingPool &operator = (const WorkStealingPool &) = delete;
+
+    uint nThreads() const
+    {
+        return m_nThreads;
+    }
+
+    void run(const std::vector<uint> &roots, const uint nTasks, const Job &job);
+
+    void push(const uint worker, const uint task);
+
+private:
+
+    struct Queue
+    {
+        std::mutex m_mutex;
+        std::deque<uint> m_tasks;
+    };
+
+    const uint m_nThreads;
+
+    Queue *m_queues;
+
+    std::vector<std::thread> m_threads;
+
+
+    const Job *m_job;
+
+    uint m_nTasks;
+
+    std::atomic<uint> m_nCompleted;
+
+    std::atomic<uint> m_nBusy;
+
+    std::atomic<uint> m_generation;
+
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_started;
+
+    bool m_stopThreads;
+
+
+    void _work(const uint worker);
+
+    bool _pop(const uint worker, uint &task);
+
+    bool _steal(const uint worker, uint &task);
+
+    void _threadLoop(const uint worker);
+
+};
+
+}
+
+#include "workstealingpool.cpp"
@@ -0,0 +1,135 @@
+#include "asyncreporter.h"
+
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+
+using namespace ignis;
+
+inline AsyncReporter::AsyncReporter(std::ostream &out, const uint capacity) :
+    m_out(out),
+    m_queue(capacity),
+    m_nPushed(0),
+    m_nStalls(0),
+    m_nWritten(0),
+    m_stop(false)
+{
+    m_thread = std::thread([this] () {_threadLoop();});
+}
+
+inline AsyncReporter::~AsyncReporter()
+{
+    m_stop = true;
+    m_thread.join();
+}
+
+inline uint AsyncReporter::registerSource(const std::string &type, const std::string &field, const std::string &unit)
+{
+    std::lock_guard<std::mutex> lock(m_sourceMutex);
+
+    m_sources.push_back({type, field, unit});
+
+    return m_sources.size() - 1;
+}
+
+inline void AsyncReporter::flush()
+{
+    while (m_nWritten.load(std::memory_order_acquire) != m_nPushed)
+    {
+        std::this_thread::yield();
+    }
+}
+
+inline void AsyncReporter::_threadLoop()
+{
+    const uint maxBuffered = 1 << 16;
+
+    std::string buffer;
+    buffer.reserve(2*maxBuffered);
+
+    uint64_t nFormatted = 0;
+
+    bool stopping = false;
+
+    Record record;
+
+    while (true)
+    {
+        bool popped = false;
+
+        while (buffer.size() < maxBuffered && m_queue.pop(record))
+        {
+            _format(record, buffer);
+            nFormatted++;
+
+            popped = true;
+        }
+
+        if (!buffer.empty())
+        {
+            m_out.write(buffer.data(), buffer.size());
+            m_out.flush();
+
+            buffer.clear();
+        }
+
+        m_nWritten.store(nFormatted, std::memory_order_release);
+
+        if (popped)
+        {
+            continue;
+        }
+
+        if (stopping)
+        {
+            break;
+        }
+
+        //Records pushed before stop was set are drained in one more pass.
+        if (m_stop)
+        {
+            stopping = true;
+            continue;
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+    }
+}
+
+inline void AsyncReporter::_format(const AsyncReporter::Record &record, std::string &buffer)
+{
+    using namespace std;
+
+    if (record.m_kind == Record::EndBlock)
+    {
+        buffer += "\n";
+        return;
+    }
+
+    if (record.m_source >= m_formatterSources.size())
+    {
+        std::lock_guard<std::mutex> lock(m_sourceMutex);
+        m_formatterSources = m_sources;
+    }
+
+    const Source &source = m_formatterSources[record.m_source];
+
+    //Same layout as Event::dumpString.
+    stringstream s, tail;
+
+    s << left
+      << "<" << setw(20) << source.m_type << " "
+      << "@" << setw(30) << source.m_field;
+
+    if (record.m_kind == Record::Value)
+    {
+        tail << "value: " << setprecision(3) << record.m_value << " " << source.m_unit;
+    }
+
+    tail << " >";
+
+    s << right << tail.str();
+
+    buffer += s.str();
+    buffer += "\n";
+}
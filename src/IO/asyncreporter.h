@@ -0,0 +1,131 @@
+#pragma once
+
+#include "../defines.h"
+
+#include "spscqueue.h"
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <stdint.h>
+
+namespace ignis
+{
+
+/*
+ * Moves the formatting and writing of event output off the event loop.
+ *
+ * The loop thread pushes fixed size records (source id, value) into an
+ * SpscQueue, and a formatter thread turns them into the same text as
+ * Event::dumpString. Text is collected in a buffer and written in large
+ * chunks, at the latest once the queue runs empty. Sources (events) are
+ * registered once with their strings. If the formatter falls behind by a
+ * whole queue, the loop waits for it rather than losing output.
+ */
+
+class AsyncReporter
+{
+public:
+
+    AsyncReporter(std::ostream &out = std::cout, const uint capacity = 1 << 14);
+
+    ~AsyncReporter();
+
+    AsyncReporter(const AsyncReporter &) = delete;
+
+    AsyncReporter &operator = (const AsyncReporter &) = delete;
+
+    uint registerSource(const std::string &type, const std::string &field, const std::string &unit);
+
+    void report(const uint source, const double value)
+    {
+        _push({source, Record::Value, value});
+    }
+
+    //! A source without a new value this cycle.
+    void report(const uint source)
+    {
+        _push({source, Record::NoValue, 0});
+    }
+
+    //! Ends the output of a cycle with an empty line.
+    void endBlock()
+    {
+        _push({0, Record::EndBlock, 0});
+    }
+
+    //! Returns once everything reported so far is written and the stream flushed.
+    void flush();
+
+    //! Number of times the loop had to wait for a full queue.
+    uint64_t nStalls() const
+    {
+        return m_nStalls;
+    }
+
+private:
+
+    struct Record
+    {
+        enum Kind : uint
+        {
+            Value,
+            NoValue,
+            EndBlock
+        };
+
+        uint m_source;
+        Kind m_kind;
+        double m_value;
+    };
+
+    struct Source
+    {
+        std::string m_type;
+        std::string m_field;
+        std::string m_unit;
+    };
+
+    std::ostream &m_out;
+
+    SpscQueue<Record> m_queue;
+
+    //! Registered by the loop thread, copied to m_formatterSources by the formatter on first use.
+    std::vector<Source> m_sources;
+    std::mutex m_sourceMutex;
+
+    std::vector<Source> m_formatterSources;
+
+    uint64_t m_nPushed;
+    uint64_t m_nStalls;
+
+    std::atomic<uint64_t> m_nWritten;
+
+    std::atomic<bool> m_stop;
+
+    std::thread m_thread;
+
+
+    void _push(const Record &record)
+    {
+        while (!m_queue.push(record))
+        {
+            m_nStalls++;
+            std::this_thread::yield();
+        }
+
+        m_nPushed++;
+    }
+
+    void _threadLoop();
+
+    void _format(const Record &record, std::string &buffer);
+
+};
+
+}
+
+#include "asyncreporter.cpp"
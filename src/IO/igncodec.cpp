@@ -0,0 +1,256 @@
+#include "igncodec.h"
+
+#include <BADAss/badass.h>
+
+#include <cstring>
+#include <algorithm>
+#include <stdexcept>
+
+using namespace ignis;
+
+namespace
+{
+
+class BitWriter
+{
+public:
+
+    BitWriter(std::string &out) :
+        m_out(out),
+        m_buffer(0),
+        m_nBits(0)
+    {
+
+    }
+
+    //! Writes the n (<= 64) lowest bits of value, most significant first.
+    void write(const uint64_t value, const uint n)
+    {
+        if (n > 32)
+        {
+            _write(value >> 32, n - 32);
+            _write(value, 32);
+        }
+
+        else
+        {
+            _write(value, n);
+        }
+    }
+
+    void finish()
+    {
+        if (m_nBits != 0)
+        {
+            m_out.push_back(static_cast<char>(m_buffer << (8 - m_nBits)));
+            m_buffer = 0;
+            m_nBits = 0;
+        }
+    }
+
+private:
+
+    std::string &m_out;
+
+    uint64_t m_buffer;
+
+    uint m_nBits;
+
+    //Less than a byte is kept between calls, so n <= 32 bits always fit.
+    void _write(const uint64_t value, const uint n)
+    {
+        m_buffer = (m_buffer << n) | (value & ((uint64_t(1) << n) - 1));
+        m_nBits += n;
+
+        while (m_nBits >= 8)
+        {
+            m_nBits -= 8;
+            m_out.push_back(static_cast<char>(m_buffer >> m_nBits));
+        }
+
+        m_buffer &= (uint64_t(1) << m_nBits) - 1;
+    }
+
+};
+
+class BitReader
+{
+public:
+
+    BitReader(const char *data, const uint64_t size) :
+        m_data(reinterpret_cast<const unsigned char*>(data)),
+        m_size(size),
+        m_position(0),
+        m_buffer(0),
+        m_nBits(0)
+    {
+
+    }
+
+    uint64_t read(const uint n)
+    {
+        if (n > 32)
+        {
+            const uint64_t high = _read(n - 32);
+
+            return (high << 32) | _read(32);
+        }
+
+        return _read(n);
+    }
+
+private:
+
+    const unsigned char *m_data;
+
+    const uint64_t m_size;
+
+    uint64_t m_position;
+
+    uint64_t m_buffer;
+
+    uint m_nBits;
+
+    uint64_t _read(const uint n)
+    {
+        while (m_nBits < n)
+        {
+            if (m_position >= m_size)
+            {
+                throw std::runtime_error("Truncated ign column chunk.");
+            }
+
+            m_buffer = (m_buffer << 8) | m_data[m_position++];
+            m_nBits += 8;
+        }
+
+        m_nBits -= n;
+
+        const uint64_t value = (m_buffer >> m_nBits) & ((uint64_t(1) << n) - 1);
+
+        m_buffer &= (uint64_t(1) << m_nBits) - 1;
+
+        return value;
+    }
+
+};
+
+inline uint64_t toBits(const double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(double));
+
+    return bits;
+}
+
+inline double fromBits(const uint64_t bits)
+{
+    double value;
+    memcpy(&value, &bits, sizeof(double));
+
+    return value;
+}
+
+}
+
+inline void XorCodec::encode(const double *values, const uint n, const uint stride, std::string &out)
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    BitWriter writer(out);
+
+    uint64_t previous = toBits(values[0]);
+    writer.write(previous, 64);
+
+    uint previousLeading = 65;
+    uint previousTrailing = 0;
+
+    for (uint i = 1; i < n; ++i)
+    {
+        const uint64_t current = toBits(values[i*stride]);
+        const uint64_t delta = current ^ previous;
+
+        previous = current;
+
+        if (delta == 0)
+        {
+            writer.write(0, 1);
+            continue;
+        }
+
+        writer.write(1, 1);
+
+        //The leading count is stored in 5 bits.
+        const uint leading = std::min(__builtin_clzll(delta), 31);
+        const uint trailing = __builtin_ctzll(delta);
+
+        if (previousLeading != 65 && leading >= previousLeading && trailing >= previousTrailing)
+        {
+            writer.write(0, 1);
+            writer.write(delta >> previousTrailing, 64 - previousLeading - previousTrailing);
+        }
+
+        else
+        {
+            const uint meaningful = 64 - leading - trailing;
+
+            writer.write(1, 1);
+            writer.write(leading, 5);
+            writer.write(meaningful & 63, 6);
+            writer.write(delta >> trailing, meaningful);
+
+            previousLeading = leading;
+            previousTrailing = trailing;
+        }
+    }
+
+    writer.finish();
+}
+
+inline void XorCodec::decode(const char *data, const uint64_t size, const uint n, double *out, const uint stride)
+{
+    if (n == 0)
+    {
+        return;
+    }
+
+    BitReader reader(data, size);
+
+    uint64_t previous = reader.read(64);
+    out[0] = fromBits(previous);
+
+    uint leading = 0;
+    uint trailing = 0;
+
+    for (uint i = 1; i < n; ++i)
+    {
+        if (reader.read(1) == 1)
+        {
+            if (reader.read(1) == 1)
+            {
+                leading = reader.read(5);
+
+                uint meaningful = reader.read(6);
+
+                if (meaningful == 0)
+                {
+                    meaningful = 64;
+                }
+
+                if (leading + meaningful > 64)
+                {
+                    throw std::runtime_error("Corrupt ign column chunk.");
+                }
+
+                trailing = 64 - leading - meaningful;
+            }
+
+            previous ^= reader.read(64 - leading - trailing) << trailing;
+        }
+
+        out[i*stride] = fromBits(previous);
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "../defines.h"
+
+#include <string>
+#include <stdint.h>
+
+namespace ignis
+{
+
+/*
+ * XOR float codec for columns of stored event values (Gorilla style).
+ *
+ * Every value is XOR-ed with its predecessor. Repeated values cost a single
+ * bit, and slowly varying series share sign, exponent and leading mantissa
+ * bits with the previous value, leaving a short window of meaningful bits.
+ * A window which fits inside the previous one is written without its
+ * position. The first value of a chunk is stored verbatim, so chunks decode
+ * independently.
+ */
+
+class XorCodec
+{
+public:
+
+    //! Appends the encoding of values[0], values[stride], ... (n values) to out.
+    static void encode(const double *values, const uint n, const uint stride, std::string &out);
+
+    //! Decodes n values from data into out[0], out[stride], ...
+    static void decode(const char *data, const uint64_t size, const uint n, double *out, const uint stride);
+
+};
+
+}
+
+#include "igncodec.cpp"
@@ -0,0 +1,155 @@
+#include "ignformat.h"
+
+#include <BADAss/badass.h>
+
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+
+using namespace ignis;
+
+namespace
+{
+
+const char ignMagic[4] = {'I', 'G', 'N', 'S'};
+
+template<typename T>
+void appendBinary(std::string &out, const T value)
+{
+    out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+inline void throwMalformed(const std::string &path, const std::string &what)
+{
+    std::stringstream s;
+    s << "ign file " << (path.empty() ? "<unnamed>" : path) << ": " << what;
+
+    throw std::runtime_error(s.str());
+}
+
+template<typename T>
+T readBinary(const char *data, const uint64_t size, uint64_t &offset, const std::string &path, const char *field)
+{
+    if (offset + sizeof(T) > size)
+    {
+        throwMalformed(path, std::string("header is truncated at ") + field + ".");
+    }
+
+    T value;
+    memcpy(&value, data + offset, sizeof(T));
+    offset += sizeof(T);
+
+    return value;
+}
+
+inline std::string readString(const char *data, const uint64_t size, uint64_t &offset, const std::string &path, const char *field)
+{
+    const uint32_t length = readBinary<uint32_t>(data, size, offset, path, field);
+
+    if (offset + length > size)
+    {
+        throwMalformed(path, std::string("header is truncated at ") + field + ".");
+    }
+
+    std::string value(data + offset, length);
+    offset += length;
+
+    return value;
+}
+
+}
+
+inline std::string IgnHeader::serialize()
+{
+    BADAss(m_units.size(), ==, m_columnNames.size(), "Every column needs a unit.");
+
+    std::string out(ignMagic, 4);
+
+    appendBinary<uint32_t>(out, m_version);
+    appendBinary<uint32_t>(out, endiannessMarker);
+    appendBinary<uint32_t>(out, m_dataType);
+    appendBinary<uint32_t>(out, m_flags);
+    appendBinary<uint32_t>(out, nCols());
+    appendBinary<uint64_t>(out, m_nRows);
+    appendBinary<uint32_t>(out, m_spacing);
+
+    const uint dataOffsetPosition = out.size();
+
+    appendBinary<uint32_t>(out, 0);
+    appendBinary<uint64_t>(out, m_indexOffset);
+
+    for (uint i = 0; i < nCols(); ++i)
+    {
+        appendBinary<uint32_t>(out, m_columnNames.at(i).size());
+        out += m_columnNames.at(i);
+
+        appendBinary<uint32_t>(out, m_units.at(i).size());
+        out += m_units.at(i);
+    }
+
+    //Aligned data lets readers view the mapped values directly.
+    out.resize(8*((out.size() + 7)/8), '\0');
+
+    m_dataOffset = out.size();
+    memcpy(&out[dataOffsetPosition], &m_dataOffset, sizeof(uint32_t));
+
+    return out;
+}
+
+inline bool IgnHeader::parse(const char *data, const uint64_t size, const std::string &path)
+{
+    if (size < 4 || memcmp(data, ignMagic, 4) != 0)
+    {
+        return false;
+    }
+
+    uint64_t offset = 4;
+
+    m_version = readBinary<uint32_t>(data, size, offset, path, "version");
+
+    if (m_version == 0 || m_version > currentVersion)
+    {
+        throwMalformed(path, "unsupported version " + std::to_string(m_version) + " (this ignis reads up to " + std::to_string((uint32_t)currentVersion) + ").");
+    }
+
+    const uint32_t marker = readBinary<uint32_t>(data, size, offset, path, "endianness");
+
+    if (marker != endiannessMarker)
+    {
+        throwMalformed(path, "endianness marker " + std::to_string(marker) + " does not match this machine.");
+    }
+
+    m_dataType = readBinary<uint32_t>(data, size, offset, path, "dtype");
+
+    if (m_dataType != Float64)
+    {
+        throwMalformed(path, "unsupported dtype " + std::to_string(m_dataType) + ".");
+    }
+
+    m_flags = readBinary<uint32_t>(data, size, offset, path, "flags");
+
+    const uint32_t nColumns = readBinary<uint32_t>(data, size, offset, path, "nCols");
+
+    m_nRows = readBinary<uint64_t>(data, size, offset, path, "nRows");
+    m_spacing = readBinary<uint32_t>(data, size, offset, path, "spacing");
+    m_dataOffset = readBinary<uint32_t>(data, size, offset, path, "dataOffset");
+    m_indexOffset = readBinary<uint64_t>(data, size, offset, path, "indexOffset");
+
+    offset = fixedSize;
+
+    m_columnNames.clear();
+    m_units.clear();
+
+    for (uint i = 0; i < nColumns; ++i)
+    {
+        m_columnNames.push_back(readString(data, size, offset, path, "column name"));
+        m_units.push_back(readString(data, size, offset, path, "unit"));
+    }
+
+    if (offset > m_dataOffset || m_dataOffset > size)
+    {
+        throwMalformed(path, "dataOffset " + std::to_string(m_dataOffset) + " is outside [" + std::to_string(offset) + ", " + std::to_string(size) + "].");
+    }
+
+    return true;
+}
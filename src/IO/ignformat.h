@@ -0,0 +1,114 @@
+#pragma once
+
+#include "../defines.h"
+
+#include <string>
+#include <vector>
+#include <stdint.h>
+
+namespace ignis
+{
+
+/*
+ * Binary header of .ign event value files (version 1).
+ *
+ *   offset  size
+ *        0     4  magic "IGNS"
+ *        4     4  version
+ *        8     4  endianness marker 0x01020304 as written by the producer
+ *       12     4  dtype (IgnHeader::Float64)
+ *       16     4  flags
+ *       20     4  nCols
+ *       24     8  nRows, patched when the file is finalized
+ *       32     4  spacing between stored cycles
+ *       36     4  dataOffset, total header size (multiple of 8)
+ *       40     8  indexOffset, block index position for compressed files
+ *       48        per column: uint32 name length, name, uint32 unit length, unit
+ *                 zero padding up to dataOffset
+ *
+ * Uncompressed data follows as nRows rows of nCols values.
+ *
+ * Compressed files (flags & Compressed) store row blocks. Each block holds
+ * one XorCodec chunk per column, back to back. The block index at
+ * indexOffset is
+ *
+ *   uint64 nBlocks
+ *   per block: uint64 first row, uint64 nRows, uint64 offset,
+ *              uint32 chunk size per column, padded to 8 bytes
+ */
+
+struct IgnHeader
+{
+    enum DataType : uint32_t
+    {
+        Float64 = 1
+    };
+
+    enum Flags : uint32_t
+    {
+        Compressed = 1
+    };
+
+    enum Layout : uint32_t
+    {
+        currentVersion = 1,
+        endiannessMarker = 0x01020304,
+        nRowsOffset = 24,
+        indexOffsetOffset = 40,
+        fixedSize = 48
+    };
+
+
+    uint32_t m_version;
+
+    uint32_t m_dataType;
+
+    uint32_t m_flags;
+
+    uint32_t m_spacing;
+
+    uint32_t m_dataOffset;
+
+    uint64_t m_nRows;
+
+    uint64_t m_indexOffset;
+
+    std::vector<std::string> m_columnNames;
+
+    std::vector<std::string> m_units;
+
+
+    IgnHeader() :
+        m_version(currentVersion),
+        m_dataType(Float64),
+        m_flags(0),
+        m_spacing(1),
+        m_dataOffset(0),
+        m_nRows(0),
+        m_indexOffset(0)
+    {
+
+    }
+
+    uint nCols() const
+    {
+        return m_columnNames.size();
+    }
+
+    bool compressed() const
+    {
+        return (m_flags & Compressed) != 0;
+    }
+
+    std::string serialize();
+
+    //! Returns false if data does not start with the magic bytes. Throws
+    //! std::runtime_error naming path and the field if the header is malformed,
+    //! truncated or unsupported.
+    bool parse(const char *data, const uint64_t size, const std::string &path = "");
+
+};
+
+}
+
+#include "ignformat.cpp"
@@ -0,0 +1,399 @@
+#include "ignreader.h"
+
+#include <BADAss/badass.h>
+
+#include <sstream>
+#include <cstring>
+#include <cerrno>
+#include <stdexcept>
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace ignis;
+
+inline IgnReader::IgnReader(const std::string &path) :
+    m_path(path),
+    m_fd(-1),
+    m_fileSize(0),
+    m_map(nullptr),
+    m_dataOffset(0),
+    m_data(nullptr),
+    m_nRows(0),
+    m_nCols(0),
+    m_cachedBlock(IGNIS_UNSET_UINT)
+{
+    m_fd = ::open(path.c_str(), O_RDONLY);
+
+    if (m_fd == -1)
+    {
+        _fail(std::string("cannot be opened: ") + strerror(errno));
+    }
+
+    struct stat status;
+
+    if (fstat(m_fd, &status) != 0)
+    {
+        _fail(std::string("cannot be inspected: ") + strerror(errno));
+    }
+
+    m_fileSize = status.st_size;
+
+    if (m_fileSize != 0)
+    {
+        void *map = mmap(nullptr, m_fileSize, PROT_READ, MAP_SHARED, m_fd, 0);
+
+        if (map == MAP_FAILED)
+        {
+            _fail(std::string("cannot be mapped: ") + strerror(errno));
+        }
+
+        m_map = static_cast<char*>(map);
+
+        madvise(m_map, m_fileSize, MADV_SEQUENTIAL);
+    }
+
+    _parseHeader();
+}
+
+inline IgnReader::~IgnReader()
+{
+    if (m_map != nullptr)
+    {
+        munmap(m_map, m_fileSize);
+    }
+
+    if (m_fd != -1)
+    {
+        ::close(m_fd);
+    }
+}
+
+inline arma::mat IgnReader::rows(const uint first, const uint last) const
+{
+    BADAss(first, <=, last);
+    BADAss(last, <=, m_nRows);
+
+    arma::mat matrix(last - first, m_nCols);
+
+    for (uint i = first; i < last; ++i)
+    {
+        const double *values = row(i);
+
+        for (uint j = 0; j < m_nCols; ++j)
+        {
+            matrix(i - first, j) = values[j];
+        }
+    }
+
+    return matrix;
+}
+
+inline arma::vec IgnReader::column(const uint j, const uint first, uint last) const
+{
+    if (last == IGNIS_UNSET_UINT)
+    {
+        last = m_nRows;
+    }
+
+    BADAss(j, <, m_nCols);
+    BADAss(first, <=, last);
+    BADAss(last, <=, m_nRows);
+
+    arma::vec values(last - first);
+
+    if (compressed() && first < last)
+    {
+        std::vector<double> chunk;
+
+        for (uint block = _findBlock(first); block < m_blockFirstRows.size() && m_blockFirstRows[block] < last; ++block)
+        {
+            const uint blockFirst = m_blockFirstRows[block];
+            const uint blockLast = blockFirst + m_blockNRows[block];
+
+            chunk.resize(m_blockNRows[block]);
+            _decodeChunk(block, j, chunk.data(), 1);
+
+            for (uint i = std::max(first, blockFirst); i < std::min(last, blockLast); ++i)
+            {
+                values(i - first) = chunk[i - blockFirst];
+            }
+        }
+
+        return values;
+    }
+
+    for (uint i = first; i < last; ++i)
+    {
+        values(i - first) = (*this)(i, j);
+    }
+
+    return values;
+}
+
+inline void IgnReader::_parseHeader()
+{
+    uint64_t dataOffset;
+
+    if (m_header.parse(m_map, m_fileSize, m_path))
+    {
+        dataOffset = m_header.m_dataOffset;
+    }
+
+    else
+    {
+        dataOffset = _parseLegacyHeader();
+    }
+
+    m_nCols = m_header.nCols();
+
+    if (compressed())
+    {
+        _parseBlockIndex();
+        return;
+    }
+
+    m_dataOffset = dataOffset;
+
+    //The mapping is page aligned, so this aligns the values. Legacy headers have arbitrary lengths.
+    if (dataOffset%sizeof(double) == 0)
+    {
+        m_data = reinterpret_cast<const double*>(m_map + dataOffset);
+    }
+
+    if (m_nCols == 0)
+    {
+        m_nRows = 0;
+        return;
+    }
+
+    const uint64_t nAvailable = (m_fileSize - dataOffset)/(m_nCols*sizeof(double));
+
+    //Files which were never finalized have no row count; trust the file size.
+    if (m_header.m_nRows == 0)
+    {
+        m_nRows = nAvailable;
+    }
+
+    else
+    {
+        if (m_header.m_nRows > nAvailable)
+        {
+            _fail("header states " + std::to_string(m_header.m_nRows) + " rows, but the file holds " + std::to_string(nAvailable) + ".");
+        }
+
+        m_nRows = m_header.m_nRows;
+    }
+}
+
+inline void IgnReader::_fail(const std::string &what)
+{
+    //The destructor does not run for a throwing constructor.
+    if (m_map != nullptr)
+    {
+        munmap(m_map, m_fileSize);
+        m_map = nullptr;
+    }
+
+    if (m_fd != -1)
+    {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+
+    throw std::runtime_error("ign file " + m_path + ": " + what);
+}
+
+inline uint64_t IgnReader::_parseLegacyHeader()
+{
+    //Pre-versioned files: space separated column names ending in a newline, then the planned nRows and nCols.
+    const char *end = m_map == nullptr ? nullptr : static_cast<const char*>(memchr(m_map, '\n', m_fileSize));
+
+    if (end == nullptr)
+    {
+        _fail("empty, or neither a versioned nor a legacy header.");
+    }
+
+    std::stringstream names(std::string(static_cast<const char*>(m_map), end));
+    std::string name;
+
+    while (names >> name)
+    {
+        m_header.m_columnNames.push_back(name);
+        m_header.m_units.push_back("");
+    }
+
+    const uint64_t dataOffset = (end - m_map) + 1 + 2*sizeof(uint);
+
+    if (dataOffset > m_fileSize)
+    {
+        _fail("legacy header is truncated after the column names.");
+    }
+
+    uint nRows;
+    memcpy(&nRows, end + 1, sizeof(uint));
+
+    const uint64_t nAvailable = (m_fileSize - dataOffset)/std::max<uint64_t>(1, m_header.nCols()*sizeof(double));
+
+    //The planned row count is written up front; runs ending early leave fewer rows.
+    m_header.m_version = 0;
+    m_header.m_nRows = std::min<uint64_t>(nRows, nAvailable);
+
+    return dataOffset;
+}
+
+inline void IgnReader::_parseBlockIndex()
+{
+    if (m_header.m_indexOffset == 0)
+    {
+        _fail("compressed file was not finalized (no block index).");
+    }
+
+    if (m_header.m_indexOffset < m_header.m_dataOffset || m_header.m_indexOffset + sizeof(uint64_t) > m_fileSize)
+    {
+        _fail("block index offset " + std::to_string(m_header.m_indexOffset) + " is outside the file.");
+    }
+
+    const char *index = m_map + m_header.m_indexOffset;
+
+    uint64_t nBlocks;
+    memcpy(&nBlocks, index, sizeof(uint64_t));
+    index += sizeof(uint64_t);
+
+    const uint64_t entrySize = 3*sizeof(uint64_t) + 8*((m_nCols*sizeof(uint32_t) + 7)/8);
+
+    //Divides rather than multiplies, so a corrupt nBlocks cannot overflow.
+    if (nBlocks > (m_fileSize - m_header.m_indexOffset - sizeof(uint64_t))/entrySize)
+    {
+        _fail("block index of " + std::to_string(nBlocks) + " blocks is truncated.");
+    }
+
+    m_blockFirstRows.resize(nBlocks);
+    m_blockNRows.resize(nBlocks);
+    m_chunkOffsets.resize(nBlocks*m_nCols);
+    m_chunkSizes.resize(nBlocks*m_nCols);
+
+    uint64_t nextRow = 0;
+
+    for (uint block = 0; block < nBlocks; ++block, index += entrySize)
+    {
+        uint64_t entry[3];
+        memcpy(entry, index, sizeof(entry));
+
+        if (entry[0] != nextRow || entry[1] == 0 || entry[1] > IGNIS_UNSET_UINT - nextRow)
+        {
+            _fail("block " + std::to_string(block) + " does not continue the rows of the previous blocks.");
+        }
+
+        m_blockFirstRows[block] = entry[0];
+        m_blockNRows[block] = entry[1];
+
+        nextRow += entry[1];
+
+        memcpy(&m_chunkSizes[block*m_nCols], index + sizeof(entry), m_nCols*sizeof(uint32_t));
+
+        uint64_t offset = entry[2];
+
+        if (offset < m_header.m_dataOffset)
+        {
+            _fail("block " + std::to_string(block) + " starts inside the header.");
+        }
+
+        for (uint j = 0; j < m_nCols; ++j)
+        {
+            m_chunkOffsets[block*m_nCols + j] = offset;
+            offset += m_chunkSizes[block*m_nCols + j];
+        }
+
+        if (offset > m_header.m_indexOffset)
+        {
+            _fail("block " + std::to_string(block) + " runs into the block index.");
+        }
+    }
+
+    m_nRows = nextRow;
+
+    if ((uint64_t)m_nRows != m_header.m_nRows)
+    {
+        _fail("block index holds " + std::to_string(m_nRows) + " rows, but the header states " + std::to_string(m_header.m_nRows) + ".");
+    }
+}
+
+inline uint IgnReader::_findBlock(const uint i) const
+{
+    BADAss(i, <, m_nRows);
+
+    return std::upper_bound(m_blockFirstRows.begin(), m_blockFirstRows.end(), (uint64_t)i) - m_blockFirstRows.begin() - 1;
+}
+
+inline void IgnReader::_decodeChunk(const uint block, const uint j, double *out, const uint stride) const
+{
+    const uint chunk = block*m_nCols + j;
+
+    XorCodec::decode(m_map + m_chunkOffsets[chunk], m_chunkSizes[chunk], m_blockNRows[block], out, stride);
+}
+
+inline const double *IgnReader::_decodedRow(const uint i) const
+{
+    if (!compressed())
+    {
+        m_cache.resize(m_nCols);
+        memcpy(m_cache.data(), _rowBytes(i), m_nCols*sizeof(double));
+
+        return m_cache.data();
+    }
+
+    const uint block = _findBlock(i);
+
+    if (block != m_cachedBlock)
+    {
+        m_cache.resize(m_blockNRows[block]*m_nCols);
+
+        for (uint j = 0; j < m_nCols; ++j)
+        {
+            _decodeChunk(block, j, m_cache.data() + j, m_nCols);
+        }
+
+        m_cachedBlock = block;
+    }
+
+    return m_cache.data() + (i - m_blockFirstRows[block])*m_nCols;
+}
+
+inline arma::mat IgnReader::_decodedRows(const uint first, const uint n) const
+{
+    arma::mat values(m_nCols, n);
+
+    if (!compressed())
+    {
+        memcpy(values.memptr(), _rowBytes(first), (uint64_t)n*m_nCols*sizeof(double));
+
+        return values;
+    }
+
+    for (uint k = 0; k < n; ++k)
+    {
+        memcpy(values.colptr(k), row(first + k), m_nCols*sizeof(double));
+    }
+
+    return values;
+}
+
+inline void IgnReader::_release(const uint first, const uint n) const
+{
+    const long pageSize = sysconf(_SC_PAGESIZE);
+
+    const char *begin = _rowBytes(first);
+    const char *end = _rowBytes(first + n);
+
+    //Only whole pages which are fully behind the block can be dropped.
+    char *pageBegin = m_map + ((begin - m_map)/pageSize)*pageSize;
+    const uint64_t length = ((end - pageBegin)/pageSize)*pageSize;
+
+    if (length != 0)
+    {
+        madvise(pageBegin, length, MADV_DONTNEED);
+    }
+}
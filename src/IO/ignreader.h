@@ -0,0 +1,200 @@
+#pragma once
+
+#include "../defines.h"
+
+#include "ignformat.h"
+#include "igncodec.h"
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+#include <armadillo>
+
+namespace ignis
+{
+
+/*
+ * Memory mapped reader for .ign event value files.
+ *
+ * Rows (stored cycles) are contiguous in the file, so any row or range of
+ * rows is available in O(1) without reading the rest of the file. The
+ * mapping is read only; views must not be written to. Files larger than
+ * memory are handled by forEachBlock(), which releases pages once a block
+ * has been processed.
+ *
+ * Compressed files are decoded one row block at a time. row() and
+ * operator() decode the block holding the row into a cache, which is
+ * overwritten by the next block, so returned pointers are only valid until
+ * the next call and the reader must not be shared between threads.
+ * column() only decodes the requested column.
+ *
+ * Legacy (pre-versioned) files do not align their values, so their rows
+ * are copied out of the mapping the same way, one row at a time.
+ *
+ * Files which cannot be opened or mapped, and headers, block indices or
+ * sizes which do not fit the file, throw std::runtime_error naming the path.
+ */
+
+class IgnReader
+{
+public:
+
+    IgnReader(const std::string &path);
+
+    ~IgnReader();
+
+    IgnReader(const IgnReader &) = delete;
+
+    IgnReader &operator = (const IgnReader &) = delete;
+
+    const std::string &path() const
+    {
+        return m_path;
+    }
+
+    uint nRows() const
+    {
+        return m_nRows;
+    }
+
+    uint nCols() const
+    {
+        return m_nCols;
+    }
+
+    const std::vector<std::string> &columnNames() const
+    {
+        return m_header.m_columnNames;
+    }
+
+    const std::vector<std::string> &units() const
+    {
+        return m_header.m_units;
+    }
+
+    const IgnHeader &header() const
+    {
+        return m_header;
+    }
+
+    bool compressed() const
+    {
+        return m_header.compressed();
+    }
+
+    const double *row(const uint i) const
+    {
+        if (m_data == nullptr)
+        {
+            return _decodedRow(i);
+        }
+
+        return m_data + (uint64_t)i*m_nCols;
+    }
+
+    double operator() (const uint i, const uint j) const
+    {
+        return row(i)[j];
+    }
+
+    //! Copies rows [first, last) into a (last - first) x nCols matrix.
+    arma::mat rows(const uint first, const uint last) const;
+
+    arma::vec column(const uint j, const uint first = 0, uint last = IGNIS_UNSET_UINT) const;
+
+    //! Calls f(firstRow, view) for consecutive blocks of at most blockRows rows.
+    //! view is a nCols x n matrix, column k holding row firstRow + k. It is a zero-copy
+    //! view over the mapping unless the file is compressed or legacy.
+    template<typename F>
+    void forEachBlock(const uint blockRows, F f) const
+    {
+        for (uint first = 0; first < m_nRows; first += blockRows)
+        {
+            const uint n = std::min(blockRows, m_nRows - first);
+
+            if (m_data == nullptr)
+            {
+                f(first, _decodedRows(first, n));
+
+                if (!compressed())
+                {
+                    _release(first, n);
+                }
+
+                continue;
+            }
+
+            const arma::mat view(const_cast<double*>(row(first)), m_nCols, n, false, true);
+
+            f(first, view);
+
+            _release(first, n);
+        }
+    }
+
+private:
+
+    const std::string m_path;
+
+    int m_fd;
+
+    uint64_t m_fileSize;
+
+    char *m_map;
+
+    uint64_t m_dataOffset;
+
+    //! The mapped values, or null if they must be copied out (compressed or unaligned).
+    const double *m_data;
+
+    uint m_nRows;
+
+    uint m_nCols;
+
+    IgnHeader m_header;
+
+
+    std::vector<uint64_t> m_blockFirstRows;
+
+    std::vector<uint64_t> m_blockNRows;
+
+    //! Position and size of the chunk of column j in block b at b*nCols + j.
+    std::vector<uint64_t> m_chunkOffsets;
+
+    std::vector<uint32_t> m_chunkSizes;
+
+    mutable std::vector<double> m_cache;
+
+    mutable uint m_cachedBlock;
+
+
+    [[noreturn]] void _fail(const std::string &what);
+
+    void _parseHeader();
+
+    uint64_t _parseLegacyHeader();
+
+    void _parseBlockIndex();
+
+    uint _findBlock(const uint i) const;
+
+    void _decodeChunk(const uint block, const uint j, double *out, const uint stride) const;
+
+    const double *_decodedRow(const uint i) const;
+
+    arma::mat _decodedRows(const uint first, const uint n) const;
+
+    const char *_rowBytes(const uint i) const
+    {
+        return m_map + m_dataOffset + (uint64_t)i*m_nCols*sizeof(double);
+    }
+
+    void _release(const uint first, const uint n) const;
+
+};
+
+}
+
+#include "ignreader.cpp"
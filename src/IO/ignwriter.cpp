@@ -0,0 +1,318 @@
+#include "ignwriter.h"
+
+#include <BADAss/badass.h>
+
+#include <chrono>
+
+using namespace ignis;
+
+inline IgnWriter::IgnWriter(const uint blockSize,
+                            const uint nBlocks,
+                            const bool async,
+                            const double flushInterval) :
+    m_compressionRows(0),
+    m_nCols(0),
+    m_writeBlock(0),
+    m_readBlock(0),
+    m_nFilled(0),
+    m_nValues(0),
+    m_nWrittenRows(0),
+    m_stopThread(false),
+    m_flushDue(false)
+{
+    setBuffering(blockSize, nBlocks, async, flushInterval);
+}
+
+inline IgnWriter::~IgnWriter()
+{
+    close();
+}
+
+inline void IgnWriter::setBuffering(const uint blockSize,
+                                    const uint nBlocks,
+                                    const bool async,
+                                    const double flushInterval)
+{
+    BADAssBool(!isOpen(), "Buffering cannot be changed while the file is open.");
+    BADAss(blockSize, !=, 0);
+    BADAss(nBlocks, >=, 2, "The ring buffer needs at least two blocks.");
+    BADAss(flushInterval, >, 0);
+
+    m_bufferBlockSize = blockSize;
+    m_async = async;
+    m_flushInterval = flushInterval;
+
+    m_blocks.resize(nBlocks);
+
+    for (Block &block : m_blocks)
+    {
+        block.m_size = 0;
+    }
+}
+
+inline void IgnWriter::setCompression(const uint blockRows)
+{
+    BADAssBool(!isOpen(), "Compression cannot be changed while the file is open.");
+
+    m_compressionRows = blockRows;
+}
+
+inline void IgnWriter::open(const std::string &path, const uint nCols)
+{
+    BADAssBool(!isOpen());
+
+    m_nCols = nCols;
+
+    if (compressed())
+    {
+        BADAss(nCols, !=, 0, "Compressed files need the number of columns.");
+
+        m_blockSize = m_compressionRows*nCols;
+    }
+
+    else
+    {
+        m_blockSize = m_bufferBlockSize;
+    }
+
+    for (Block &block : m_blocks)
+    {
+        block.m_data.resize(m_blockSize);
+        block.m_size = 0;
+    }
+
+    m_file.open(path, std::ios::binary);
+
+    BADAssBool(m_file.good(), "Issues with opening file.", [&] ()
+    {
+        BADAssSimpleDump(path);
+    });
+
+    m_writeBlock = 0;
+    m_readBlock = 0;
+    m_nFilled = 0;
+    m_nValues = 0;
+    m_flushDue = false;
+
+    m_nWrittenRows = 0;
+    m_blockIndex.clear();
+    m_chunkSizes.clear();
+
+    if (m_async)
+    {
+        m_stopThread = false;
+        m_thread = std::thread(&IgnWriter::_threadLoop, this);
+    }
+}
+
+inline void IgnWriter::writeRaw(const char *data, const uint size)
+{
+    BADAssBool(isOpen(), "event file is not open but asked to write.");
+
+    m_file.write(data, size);
+}
+
+inline void IgnWriter::write(const double *values, const uint n)
+{
+    for (uint i = 0; i < n; ++i)
+    {
+        write(values[i]);
+    }
+}
+
+inline void IgnWriter::flush()
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    _handOff();
+
+    _waitUntilWritten();
+}
+
+inline void IgnWriter::patch(const uint64_t offset, const char *data, const uint size)
+{
+    BADAssBool(isOpen(), "event file is not open but asked to write.");
+
+    flush();
+
+    const std::streampos end = m_file.tellp();
+
+    m_file.seekp(offset);
+    m_file.write(data, size);
+    m_file.seekp(end);
+}
+
+inline uint64_t IgnWriter::writeBlockIndex()
+{
+    BADAssBool(isOpen(), "event file is not open but asked to write.");
+    BADAssBool(compressed(), "Only compressed files have a block index.");
+
+    flush();
+
+    const uint64_t offset = m_file.tellp();
+    const uint64_t nBlocks = m_blockIndex.size()/3;
+
+    m_file.write(reinterpret_cast<const char*>(&nBlocks), sizeof(uint64_t));
+
+    for (uint block = 0; block < nBlocks; ++block)
+    {
+        m_file.write(reinterpret_cast<const char*>(&m_blockIndex[3*block]), 3*sizeof(uint64_t));
+        m_file.write(reinterpret_cast<const char*>(&m_chunkSizes[block*m_nCols]), m_nCols*sizeof(uint32_t));
+
+        if (m_nCols%2 != 0)
+        {
+            const uint32_t padding = 0;
+            m_file.write(reinterpret_cast<const char*>(&padding), sizeof(uint32_t));
+        }
+    }
+
+    m_file.flush();
+
+    return offset;
+}
+
+inline void IgnWriter::close()
+{
+    if (!isOpen())
+    {
+        return;
+    }
+
+    _handOff();
+
+    if (m_async)
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stopThread = true;
+        }
+
+        m_filled.notify_one();
+        m_thread.join();
+    }
+
+    m_file.close();
+}
+
+inline void IgnWriter::_handOff()
+{
+    Block &block = m_blocks[m_writeBlock];
+
+    if (block.m_size == 0)
+    {
+        return;
+    }
+
+    if (!m_async)
+    {
+        _writeBlock(block);
+        block.m_size = 0;
+
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    m_nFilled++;
+    m_writeBlock = (m_writeBlock + 1)%m_blocks.size();
+
+    m_filled.notify_one();
+
+    //The next block is only free once the writer has caught up.
+    m_emptied.wait(lock, [this] () {return m_nFilled < m_blocks.size();});
+}
+
+inline void IgnWriter::_writeBlock(IgnWriter::Block &block)
+{
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+
+    if (compressed())
+    {
+        _writeCompressedBlock(block);
+    }
+
+    else
+    {
+        m_file.write(reinterpret_cast<const char*>(block.m_data.data()), block.m_size*sizeof(double));
+        m_file.flush();
+    }
+
+    if (m_writeListener)
+    {
+        m_writeListener(block.m_size, start);
+    }
+}
+
+inline void IgnWriter::_threadLoop()
+{
+    const std::chrono::duration<double> interval(m_flushInterval);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+
+    while (true)
+    {
+        if (!m_filled.wait_for(lock, interval, [this] () {return m_nFilled != 0 || m_stopThread;}))
+        {
+            m_flushDue = true;
+            continue;
+        }
+
+        if (m_nFilled == 0)
+        {
+            break;
+        }
+
+        Block &block = m_blocks[m_readBlock];
+
+        lock.unlock();
+        _writeBlock(block);
+        lock.lock();
+
+        block.m_size = 0;
+        m_readBlock = (m_readBlock + 1)%m_blocks.size();
+        m_nFilled--;
+
+        m_emptied.notify_all();
+    }
+}
+
+inline void IgnWriter::_waitUntilWritten()
+{
+    if (!m_async)
+    {
+        m_file.flush();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_emptied.wait(lock, [this] () {return m_nFilled == 0;});
+}
+
+inline void IgnWriter::_writeCompressedBlock(IgnWriter::Block &block)
+{
+    BADAss(block.m_size%m_nCols, ==, 0, "Compressed blocks must hold whole rows.");
+
+    const uint nRows = block.m_size/m_nCols;
+
+    m_blockIndex.push_back(m_nWrittenRows);
+    m_blockIndex.push_back(nRows);
+    m_blockIndex.push_back(m_file.tellp());
+
+    for (uint j = 0; j < m_nCols; ++j)
+    {
+        m_encoded.clear();
+
+        XorCodec::encode(block.m_data.data() + j, nRows, m_nCols, m_encoded);
+
+        m_chunkSizes.push_back(m_encoded.size());
+
+        m_file.write(m_encoded.data(), m_encoded.size());
+    }
+
+    m_file.flush();
+
+    m_nWrittenRows += nRows;
+}
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "../defines.h"
+
+#include "igncodec.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <stdint.h>
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <chrono>
+
+namespace ignis
+{
+
+/*
+ * Buffered writer for stored event values.
+ *
+ * Values are accumulated in a ring of fixed size blocks. Full blocks are
+ * handed to a background thread which writes them to disk, so the event
+ * loop only touches memory. Partially filled blocks are handed over when
+ * the flush interval has passed (checked at row ends), on flush() and on
+ * close(). In synchronous mode blocks are written by the calling thread.
+ *
+ * With compression enabled, each block holds whole rows and is written as
+ * one XorCodec chunk per column (see IgnHeader for the layout). Encoding
+ * happens on the writing thread.
+ */
+
+class IgnWriter
+{
+public:
+
+    IgnWriter(const uint blockSize = 1 << 16,
+              const uint nBlocks = 8,
+              const bool async = true,
+              const double flushInterval = 5.0);
+
+    ~IgnWriter();
+
+    void setBuffering(const uint blockSize,
+                      const uint nBlocks,
+                      const bool async,
+                      const double flushInterval);
+
+    //! blockRows rows are encoded together; 0 writes raw values. Replaces the buffering block size.
+    void setCompression(const uint blockRows);
+
+    bool compressed() const
+    {
+        return m_compressionRows != 0;
+    }
+
+    //! nCols is required for compressed files.
+    void open(const std::string &path, const uint nCols = 0);
+
+    bool isOpen() const
+    {
+        return m_file.is_open();
+    }
+
+    //! Written directly, so it must precede any buffered values.
+    void writeRaw(const char *data, const uint size);
+
+    void write(const double value)
+    {
+        Block &block = m_blocks[m_writeBlock];
+
+        block.m_data[block.m_size++] = value;
+        m_nValues++;
+
+        if (block.m_size == m_blockSize)
+        {
+            _handOff();
+        }
+    }
+
+    void write(const double *values, const uint n);
+
+    //! Marks the end of a row. Hands over the current block if the flush interval has passed.
+    void endRow()
+    {
+        if (m_flushDue.load(std::memory_order_relaxed))
+        {
+            m_flushDue = false;
+            _handOff();
+        }
+    }
+
+    void flush();
+
+    typedef std::function<void(const uint64_t nValues, const std::chrono::steady_clock::time_point start)> WriteListener;
+
+    //! Called by the writing thread after each block it wrote, e.g. for tracing.
+    void setWriteListener(const WriteListener &listener)
+    {
+        m_writeListener = listener;
+    }
+
+    //! Overwrites already written bytes, e.g. header fields known only at the end.
+    void patch(const uint64_t offset, const char *data, const uint size);
+
+    //! Flushes and appends the index of compressed blocks. Returns its file offset.
+    uint64_t writeBlockIndex();
+
+    void close();
+
+    //! Number of values received since open().
+    uint64_t nValues() const
+    {
+        return m_nValues;
+    }
+
+private:
+
+    struct Block
+    {
+        std::vector<double> m_data;
+        uint m_size;
+    };
+
+    std::ofstream m_file;
+
+    uint m_bufferBlockSize;
+
+    uint m_blockSize;
+
+    bool m_async;
+
+    double m_flushInterval;
+
+    uint m_compressionRows;
+
+    uint m_nCols;
+
+
+    std::vector<Block> m_blocks;
+
+    uint m_writeBlock;
+
+    uint m_readBlock;
+
+    uint m_nFilled;
+
+    uint64_t m_nValues;
+
+
+    uint64_t m_nWrittenRows;
+
+    //! (first row, nRows, offset) per compressed block.
+    std::vector<uint64_t> m_blockIndex;
+
+    std::vector<uint32_t> m_chunkSizes;
+
+    std::string m_encoded;
+
+
+    std::thread m_thread;
+
+    std::mutex m_mutex;
+
+    std::condition_variable m_filled;
+
+    std::condition_variable m_emptied;
+
+    bool m_stopThread;
+
+    std::atomic<bool> m_flushDue;
+
+    WriteListener m_writeListener;
+
+
+    void _handOff();
+
+    void _writeBlock(Block &block);
+
+    void _writeCompressedBlock(Block &block);
+
+    void _threadLoop();
+
+    void _waitUntilWritten();
+
+};
+
+}
+
+#include "ignwriter.cpp"
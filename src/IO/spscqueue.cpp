@@ -0,0 +1,25 @@
+#include "spscqueue.h"
+
+#include <BADAss/badass.h>
+
+using namespace ignis;
+
+template<typename T>
+SpscQueue<T>::SpscQueue(const uint capacity) :
+    m_tail(0),
+    m_cachedHead(0),
+    m_head(0),
+    m_cachedTail(0)
+{
+    BADAss(capacity, !=, 0);
+
+    uint size = 1;
+
+    while (size < capacity)
+    {
+        size *= 2;
+    }
+
+    m_items.resize(size);
+    m_mask = size - 1;
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "../defines.h"
+
+#include <vector>
+#include <atomic>
+#include <stdint.h>
+
+namespace ignis
+{
+
+/*
+ * Bounded lock-free queue for one producer and one consumer thread.
+ *
+ * Both ends keep a cached copy of the other end's index, so the shared
+ * indices are only read when the cached one says the queue is full or
+ * empty. The indices live on separate cache lines.
+ */
+
+template<typename T>
+class SpscQueue
+{
+public:
+
+    //! Rounded up to a power of two.
+    SpscQueue(const uint capacity);
+
+    SpscQueue(const SpscQueue &) = delete;
+
+    SpscQueue &operator = (const SpscQueue &) = delete;
+
+    uint capacity() const
+    {
+        return m_items.size();
+    }
+
+    //! Producer side. False if the queue is full.
+    bool push(const T &item)
+    {
+        const uint64_t tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_cachedHead == m_items.size())
+        {
+            m_cachedHead = m_head.load(std::memory_order_acquire);
+
+            if (tail - m_cachedHead == m_items.size())
+            {
+                return false;
+            }
+        }
+
+        m_items[tail & m_mask] = item;
+
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    //! Consumer side. False if the queue is empty.
+    bool pop(T &item)
+    {
+        const uint64_t head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_cachedTail)
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+
+            if (head == m_cachedTail)
+            {
+                return false;
+            }
+        }
+
+        item = m_items[head & m_mask];
+
+        m_head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+private:
+
+    std::vector<T> m_items;
+
+    uint64_t m_mask;
+
+    char m_padding0[64];
+
+    //! Written by the producer.
+    std::atomic<uint64_t> m_tail;
+    uint64_t m_cachedHead;
+
+    char m_padding1[64];
+
+    //! Written by the consumer.
+    std::atomic<uint64_t> m_head;
+    uint64_t m_cachedTail;
+
+    char m_padding2[64];
+
+};
+
+}
+
+#include "spscqueue.cpp"
@@ -0,0 +1,273 @@
+#include "containmentgrid.h"
+
+using namespace ignis;
+
+template<typename pT, uint D>
+ContainmentGrid<pT, D>::ContainmentGrid(MainMesh<pT, D> *mainMesh, const uint cellsPerDimension) :
+    m_mainMesh(mainMesh),
+    m_cellsPerDimension(cellsPerDimension),
+    m_nCells(0),
+    m_positions(PositionSpan<pT, D>::none())
+{
+    BADAss(cellsPerDimension, !=, 0, "The spatial index needs at least one cell per dimension.");
+}
+
+template<typename pT, uint D>
+bool ContainmentGrid<pT, D>::outdated()
+{
+    if (m_nCells == 0)
+    {
+        return true;
+    }
+
+    for (uint d = 0; d < D; ++d)
+    {
+        if (m_origin[d] != m_mainMesh->topology(d, 0) || m_upper[d] != m_mainMesh->topology(d, 1))
+        {
+            return true;
+        }
+    }
+
+    m_scratchFields.clear();
+    m_scratchParents.clear();
+
+    m_mainMesh->_flattenSubFields(m_scratchFields, m_scratchParents);
+
+    if (m_scratchFields != m_fields || m_scratchParents != m_parents)
+    {
+        return true;
+    }
+
+    for (uint f = 0; f < m_fields.size(); ++f)
+    {
+        for (uint d = 0; d < D; ++d)
+        {
+            if (m_bounds.at(2*(f*D + d))     != m_fields.at(f)->topology(d, 0) ||
+                m_bounds.at(2*(f*D + d) + 1) != m_fields.at(f)->topology(d, 1))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+template<typename pT, uint D>
+void ContainmentGrid<pT, D>::build()
+{
+    m_fields.clear();
+    m_parents.clear();
+    m_customFields.clear();
+    m_bounds.clear();
+
+    m_mainMesh->_flattenSubFields(m_fields, m_parents);
+
+    for (uint f = 0; f < m_fields.size(); ++f)
+    {
+        for (uint d = 0; d < D; ++d)
+        {
+            m_bounds.push_back(m_fields.at(f)->topology(d, 0));
+            m_bounds.push_back(m_fields.at(f)->topology(d, 1));
+        }
+
+        if (m_fields.at(f)->hasCustomGeometry())
+        {
+            m_customFields.push_back(f);
+        }
+    }
+
+    m_nCells = 1;
+    for (uint d = 0; d < D; ++d)
+    {
+        m_origin[d] = m_mainMesh->topology(d, 0);
+        m_upper[d] = m_mainMesh->topology(d, 1);
+
+        const double width = m_upper[d] - m_origin[d];
+
+        m_inverseCellWidth[d] = width > 0 ? m_cellsPerDimension/width : 0;
+
+        m_nCells *= m_cellsPerDimension;
+    }
+
+    m_cellStart.resize(m_nCells + 1);
+    m_candidates.clear();
+
+    double cellLow[D];
+    double cellHigh[D];
+
+    for (uint cell = 0; cell < m_nCells; ++cell)
+    {
+        m_cellStart.at(cell) = m_candidates.size();
+
+        uint rest = cell;
+        for (uint d = 0; d < D; ++d)
+        {
+            const uint c = rest%m_cellsPerDimension;
+            const double width = (m_upper[d] - m_origin[d])/m_cellsPerDimension;
+
+            rest /= m_cellsPerDimension;
+
+            cellLow[d] = m_origin[d] + c*width;
+            cellHigh[d] = cellLow[d] + width;
+        }
+
+        for (uint f = 0; f < m_fields.size(); ++f)
+        {
+            if (m_fields.at(f)->hasCustomGeometry())
+            {
+                continue;
+            }
+
+            bool overlaps = true;
+            bool covers = true;
+
+            for (uint d = 0; d < D; ++d)
+            {
+                const pT &low = m_bounds.at(2*(f*D + d));
+                const pT &high = m_bounds.at(2*(f*D + d) + 1);
+
+                overlaps = overlaps && (low <= cellHigh[d]) && (high >= cellLow[d]);
+
+                //Strict inequalities keep round-off at cell edges on the tested path.
+                covers = covers && (low < cellLow[d]) && (high > cellHigh[d]);
+            }
+
+            if (overlaps)
+            {
+                m_candidates.push_back({f, covers});
+            }
+        }
+    }
+
+    m_cellStart.at(m_nCells) = m_candidates.size();
+
+    m_targets.resize(m_fields.size());
+}
+
+template<typename pT, uint D>
+uint ContainmentGrid<pT, D>::_cellIndex(const pT *x) const
+{
+    uint cell = 0;
+    uint stride = 1;
+
+    for (uint d = 0; d < D; ++d)
+    {
+        uint c = (x[d] - m_origin[d])*m_inverseCellWidth[d];
+
+        if (c >= m_cellsPerDimension)
+        {
+            c = m_cellsPerDimension - 1;
+        }
+
+        cell += c*stride;
+        stride *= m_cellsPerDimension;
+    }
+
+    return cell;
+}
+
+template<typename pT, uint D>
+bool ContainmentGrid<pT, D>::_isWithin(const uint field, const pT *x) const
+{
+    const pT *bounds = &m_bounds[2*field*D];
+
+    for (uint d = 0; d < D; ++d)
+    {
+        if (x[d] < bounds[2*d] || x[d] > bounds[2*d + 1])
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename pT, uint D>
+void ContainmentGrid<pT, D>::appendToChain(const std::vector<uint> &parents,
+                                        const uint field,
+                                        const uint i,
+                                        std::vector<std::vector<uint> *> &targets)
+{
+    //Particles arrive in increasing order, so a matching tail means all parents have it as well.
+    for (uint f = field; f != IGNIS_UNSET_UINT; f = parents[f])
+    {
+        std::vector<uint> &atoms = *targets[f];
+
+        if (!atoms.empty() && atoms.back() == i)
+        {
+            break;
+        }
+
+        atoms.push_back(i);
+    }
+}
+
+template<typename pT, uint D>
+void ContainmentGrid<pT, D>::bin(const uint i, std::vector<std::vector<uint> *> &targets) const
+{
+    const PositionHandler<pT, D> &particles = *m_mainMesh->m_particles;
+
+    pT x[D];
+
+    bool insideMainMesh = true;
+    for (uint d = 0; d < D; ++d)
+    {
+        x[d] = m_positions.valid() ? m_positions(i, d) : particles(i, d);
+
+        insideMainMesh = insideMainMesh && (x[d] >= m_origin[d]) && (x[d] <= m_upper[d]);
+    }
+
+    for (const uint &f : m_customFields)
+    {
+        if (m_fields[f]->isWithinThis(i))
+        {
+            appendToChain(m_parents, f, i, targets);
+        }
+    }
+
+    if (!insideMainMesh)
+    {
+        return;
+    }
+
+    const uint cell = _cellIndex(x);
+
+    for (uint k = m_cellStart[cell]; k < m_cellStart[cell + 1]; ++k)
+    {
+        const Candidate &candidate = m_candidates[k];
+
+        if (candidate.m_covers || _isWithin(candidate.m_field, x))
+        {
+            appendToChain(m_parents, candidate.m_field, i, targets);
+        }
+    }
+}
+
+template<typename pT, uint D>
+void ContainmentGrid<pT, D>::prepare()
+{
+    if (outdated())
+    {
+        build();
+    }
+
+    m_positions = m_mainMesh->m_particles->span();
+}
+
+template<typename pT, uint D>
+void ContainmentGrid<pT, D>::fill()
+{
+    prepare();
+
+    for (uint f = 0; f < m_fields.size(); ++f)
+    {
+        m_fields.at(f)->resetContents();
+        m_targets.at(f) = &m_fields.at(f)->m_atoms;
+    }
+
+    for (uint i = 0; i < m_mainMesh->m_particles->count(); ++i)
+    {
+        bin(i, m_targets);
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "../meshfield.h"
+
+#include "../../positionhandler.h"
+
+#include <vector>
+
+namespace ignis
+{
+
+/*
+ * Uniform cell grid over the main mesh used to resolve which subfields
+ * contain a particle without walking the full subfield tree.
+ *
+ * Every cell stores the (flattened) subfields overlapping it. Fields which
+ * fully cover a cell are accepted without a box test. A particle matching a
+ * field is appended to that field and all of its parents, reproducing the
+ * results of MeshField::checkSubFields().
+ */
+
+template<typename pT, uint D>
+class ContainmentGrid
+{
+public:
+
+    ContainmentGrid(MainMesh<pT, D> *mainMesh, const uint cellsPerDimension);
+
+    bool outdated();
+
+    void build();
+
+    void prepare();
+
+    void bin(const uint i, std::vector<std::vector<uint> *> &targets) const;
+
+    void fill();
+
+    const std::vector<MeshField<pT, D> *> &fields() const
+    {
+        return m_fields;
+    }
+
+    const std::vector<uint> &parents() const
+    {
+        return m_parents;
+    }
+
+    uint cellsPerDimension() const
+    {
+        return m_cellsPerDimension;
+    }
+
+    static void appendToChain(const std::vector<uint> &parents,
+                              const uint field,
+                              const uint i,
+                              std::vector<std::vector<uint> *> &targets);
+
+private:
+
+    struct Candidate
+    {
+        uint m_field;
+        bool m_covers;
+    };
+
+    MainMesh<pT, D> *m_mainMesh;
+
+    const uint m_cellsPerDimension;
+
+    uint m_nCells;
+
+
+    std::vector<MeshField<pT, D> *> m_fields;
+
+    std::vector<uint> m_parents;
+
+    std::vector<uint> m_customFields;
+
+    std::vector<pT> m_bounds;
+
+
+    double m_origin[D];
+
+    double m_upper[D];
+
+    double m_inverseCellWidth[D];
+
+
+    std::vector<uint> m_cellStart;
+
+    std::vector<Candidate> m_candidates;
+
+
+    std::vector<MeshField<pT, D> *> m_scratchFields;
+
+    std::vector<uint> m_scratchParents;
+
+    std::vector<std::vector<uint> *> m_targets;
+
+    PositionSpan<pT, D> m_positions;
+
+
+    uint _cellIndex(const pT *x) const;
+
+    bool _isWithin(const uint field, const pT *x) const;
+
+};
+
+}
+
+#include "containmentgrid.cpp"
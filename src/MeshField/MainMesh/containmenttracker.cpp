@@ -0,0 +1,317 @@
+#include "containmenttracker.h"
+
+using namespace ignis;
+
+template<typename pT, uint D>
+ContainmentTracker<pT, D>::ContainmentTracker(MainMesh<pT, D> *mainMesh, const double skin) :
+    m_mainMesh(mainMesh),
+    m_skin(skin),
+    m_nParticles(IGNIS_UNSET_UINT),
+    m_maxDepth(0),
+    m_nRebinned(0),
+    m_siblingsOverlap(false),
+    m_positions(PositionSpan<pT, D>::none())
+{
+    BADAss(skin, >=, 0, "The containment skin cannot be negative.");
+}
+
+template<typename pT, uint D>
+bool ContainmentTracker<pT, D>::outdated()
+{
+    if (m_nParticles != m_mainMesh->m_particles->count())
+    {
+        return true;
+    }
+
+    m_scratchFields.clear();
+    m_scratchParents.clear();
+
+    m_mainMesh->_flattenSubFields(m_scratchFields, m_scratchParents);
+
+    if (m_scratchFields != m_fields || m_scratchParents != m_parents)
+    {
+        return true;
+    }
+
+    for (uint f = 0; f < m_fields.size(); ++f)
+    {
+        for (uint d = 0; d < D; ++d)
+        {
+            if (m_bounds.at(2*(f*D + d))     != m_fields.at(f)->topology(d, 0) ||
+                m_bounds.at(2*(f*D + d) + 1) != m_fields.at(f)->topology(d, 1))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+template<typename pT, uint D>
+void ContainmentTracker<pT, D>::build()
+{
+    m_fields.clear();
+    m_parents.clear();
+    m_depths.clear();
+    m_bounds.clear();
+
+    m_mainMesh->_flattenSubFields(m_fields, m_parents);
+
+    m_maxDepth = 0;
+    for (uint f = 0; f < m_fields.size(); ++f)
+    {
+        const uint parent = m_parents.at(f);
+
+        m_depths.push_back(parent == IGNIS_UNSET_UINT ? 0 : m_depths.at(parent) + 1);
+
+        m_maxDepth = std::max(m_maxDepth, m_depths.back() + 1);
+
+        for (uint d = 0; d < D; ++d)
+        {
+            m_bounds.push_back(m_fields.at(f)->topology(d, 0));
+            m_bounds.push_back(m_fields.at(f)->topology(d, 1));
+        }
+    }
+
+    m_childStart.assign(_root() + 2, 0);
+
+    for (uint f = 0; f < m_fields.size(); ++f)
+    {
+        const uint parent = m_parents.at(f);
+        m_childStart.at((parent == IGNIS_UNSET_UINT ? _root() : parent) + 1)++;
+    }
+
+    for (uint f = 0; f <= _root(); ++f)
+    {
+        m_childStart.at(f + 1) += m_childStart.at(f);
+    }
+
+    //Flattening is depth first, so children end up in the order they were added.
+    m_children.resize(m_fields.size());
+    std::vector<uint> childCount(_root() + 1, 0);
+
+    for (uint f = 0; f < m_fields.size(); ++f)
+    {
+        const uint parent = m_parents.at(f) == IGNIS_UNSET_UINT ? _root() : m_parents.at(f);
+        m_children.at(m_childStart.at(parent) + childCount.at(parent)++) = f;
+    }
+
+    m_nParticles = m_mainMesh->m_particles->count();
+
+    m_siblingsOverlap = _siblingsOverlap();
+
+    if (m_siblingsOverlap)
+    {
+        cerr << "warning: overlapping sibling subfields. Containments are updated by the full pass." << endl;
+
+        m_nRebinned = 0;
+        return;
+    }
+
+    for (MeshField<pT, D> *field : m_fields)
+    {
+        field->resetContents();
+    }
+
+    m_leaves.assign(m_nParticles, IGNIS_UNSET_UINT);
+    m_slots.assign(m_nParticles*m_maxDepth, IGNIS_UNSET_UINT);
+
+    for (uint i = 0; i < m_nParticles; ++i)
+    {
+        const uint leaf = _descend(_root(), i);
+
+        if (leaf != IGNIS_UNSET_UINT)
+        {
+            _insert(leaf, i);
+        }
+    }
+
+    m_nRebinned = m_nParticles;
+}
+
+template<typename pT, uint D>
+bool ContainmentTracker<pT, D>::update()
+{
+    m_positions = m_mainMesh->m_particles->span();
+
+    if (outdated())
+    {
+        build();
+        return !m_siblingsOverlap;
+    }
+
+    if (m_siblingsOverlap)
+    {
+        return false;
+    }
+
+    m_nRebinned = 0;
+
+    for (uint i = 0; i < m_nParticles; ++i)
+    {
+        if (_staysInLeaf(i))
+        {
+            continue;
+        }
+
+        m_nRebinned++;
+
+        const uint oldLeaf = m_leaves[i];
+
+        uint ancestor = oldLeaf;
+        while (ancestor != IGNIS_UNSET_UINT && !_isWithin(ancestor, i))
+        {
+            ancestor = m_parents[ancestor];
+        }
+
+        const uint newLeaf = _descend(ancestor == IGNIS_UNSET_UINT ? _root() : ancestor, i);
+
+        if (oldLeaf != IGNIS_UNSET_UINT)
+        {
+            _remove(oldLeaf, i, ancestor);
+        }
+
+        if (newLeaf != IGNIS_UNSET_UINT)
+        {
+            _insert(newLeaf, i, ancestor);
+        }
+    }
+
+    return true;
+}
+
+template<typename pT, uint D>
+bool ContainmentTracker<pT, D>::_siblingsOverlap() const
+{
+    for (uint f = 0; f <= _root(); ++f)
+    {
+        for (uint k = m_childStart.at(f); k < m_childStart.at(f + 1); ++k)
+        {
+            for (uint l = k + 1; l < m_childStart.at(f + 1); ++l)
+            {
+                bool overlaps = true;
+
+                for (uint d = 0; d < D; ++d)
+                {
+                    const uint a = 2*(m_children.at(k)*D + d);
+                    const uint b = 2*(m_children.at(l)*D + d);
+
+                    overlaps = overlaps && (m_bounds.at(a) < m_bounds.at(b + 1)) && (m_bounds.at(b) < m_bounds.at(a + 1));
+                }
+
+                if (overlaps)
+                {
+                    return true;
+                }
+            }
+        }
+    }
+
+    return false;
+}
+
+template<typename pT, uint D>
+bool ContainmentTracker<pT, D>::_isWithin(const uint field, const uint i, const double skin) const
+{
+    if (m_fields[field]->hasCustomGeometry())
+    {
+        return m_fields[field]->isWithinThis(i);
+    }
+
+    const PositionHandler<pT, D> &particles = *m_mainMesh->m_particles;
+    const pT *bounds = &m_bounds[2*field*D];
+
+    for (uint d = 0; d < D; ++d)
+    {
+        const pT x = m_positions.valid() ? m_positions(i, d) : particles(i, d);
+
+        if (x < bounds[2*d] - skin || x > bounds[2*d + 1] + skin)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename pT, uint D>
+uint ContainmentTracker<pT, D>::_descend(uint field, const uint i) const
+{
+    bool descended = true;
+
+    while (descended)
+    {
+        descended = false;
+
+        for (uint k = m_childStart[field]; k < m_childStart[field + 1]; ++k)
+        {
+            if (_isWithin(m_children[k], i))
+            {
+                field = m_children[k];
+                descended = true;
+                break;
+            }
+        }
+    }
+
+    return field == _root() ? IGNIS_UNSET_UINT : field;
+}
+
+template<typename pT, uint D>
+bool ContainmentTracker<pT, D>::_staysInLeaf(const uint i) const
+{
+    const uint leaf = m_leaves[i];
+
+    if (leaf != IGNIS_UNSET_UINT && !_isWithin(leaf, i, m_skin))
+    {
+        return false;
+    }
+
+    const uint field = leaf == IGNIS_UNSET_UINT ? _root() : leaf;
+
+    for (uint k = m_childStart[field]; k < m_childStart[field + 1]; ++k)
+    {
+        if (_isWithin(m_children[k], i))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+template<typename pT, uint D>
+void ContainmentTracker<pT, D>::_insert(const uint leaf, const uint i, const uint until)
+{
+    for (uint f = leaf; f != until; f = m_parents[f])
+    {
+        std::vector<uint> &atoms = m_fields[f]->m_atoms;
+
+        m_slots[i*m_maxDepth + m_depths[f]] = atoms.size();
+        atoms.push_back(i);
+    }
+
+    m_leaves[i] = leaf;
+}
+
+template<typename pT, uint D>
+void ContainmentTracker<pT, D>::_remove(const uint leaf, const uint i, const uint until)
+{
+    for (uint f = leaf; f != until; f = m_parents[f])
+    {
+        std::vector<uint> &atoms = m_fields[f]->m_atoms;
+
+        const uint depth = m_depths[f];
+        const uint slot = m_slots[i*m_maxDepth + depth];
+        const uint last = atoms.back();
+
+        atoms[slot] = last;
+        m_slots[last*m_maxDepth + depth] = slot;
+
+        atoms.pop_back();
+        m_slots[i*m_maxDepth + depth] = IGNIS_UNSET_UINT;
+    }
+
+    m_leaves[i] = until;
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "../meshfield.h"
+
+#include "../../positionhandler.h"
+
+#include <vector>
+
+namespace ignis
+{
+
+/*
+ * Incremental subfield containment.
+ *
+ * Remembers the deepest subfield (leaf) holding each particle together with
+ * the particle's slot in the atom list of every field along the leaf's
+ * parent chain. Each update only re-bins particles which have left their
+ * leaf box (expanded by the skin distance) or entered one of its children.
+ * Atom lists are patched by swap-remove, so they are no longer sorted.
+ *
+ * Sibling subfields must not overlap, since a particle has a single leaf.
+ * Overlapping siblings are detected on build, and update() then leaves the
+ * containments to the full pass.
+ */
+
+template<typename pT, uint D>
+class ContainmentTracker
+{
+public:
+
+    ContainmentTracker(MainMesh<pT, D> *mainMesh, const double skin);
+
+    bool outdated();
+
+    void build();
+
+    //! Returns false if the containments must be updated by the full pass instead.
+    bool update();
+
+    const double &skin() const
+    {
+        return m_skin;
+    }
+
+    uint leaf(const uint i) const
+    {
+        return m_leaves.at(i);
+    }
+
+    const std::vector<MeshField<pT, D> *> &fields() const
+    {
+        return m_fields;
+    }
+
+    uint nRebinned() const
+    {
+        return m_nRebinned;
+    }
+
+private:
+
+    MainMesh<pT, D> *m_mainMesh;
+
+    const double m_skin;
+
+    uint m_nParticles;
+
+    uint m_maxDepth;
+
+    uint m_nRebinned;
+
+    bool m_siblingsOverlap;
+
+
+    std::vector<MeshField<pT, D> *> m_fields;
+
+    std::vector<uint> m_parents;
+
+    std::vector<uint> m_depths;
+
+    std::vector<pT> m_bounds;
+
+    //! Children of field f are m_children[m_childStart[f] ... m_childStart[f + 1]),
+    //! the top level subfields are stored last (f = number of fields).
+    std::vector<uint> m_childStart;
+
+    std::vector<uint> m_children;
+
+
+    std::vector<uint> m_leaves;
+
+    std::vector<uint> m_slots;
+
+
+    std::vector<MeshField<pT, D> *> m_scratchFields;
+
+    std::vector<uint> m_scratchParents;
+
+    PositionSpan<pT, D> m_positions;
+
+
+    uint _root() const
+    {
+        return m_fields.size();
+    }
+
+    bool _siblingsOverlap() const;
+
+    bool _isWithin(const uint field, const uint i, const double skin = 0) const;
+
+    uint _descend(uint field, const uint i) const;
+
+    bool _staysInLeaf(const uint i) const;
+
+    void _insert(const uint leaf, const uint i, const uint until = IGNIS_UNSET_UINT);
+
+    void _remove(const uint leaf, const uint i, const uint until = IGNIS_UNSET_UINT);
+
+};
+
+}
+
+#include "containmenttracker.cpp"
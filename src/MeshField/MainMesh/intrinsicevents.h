@@ -8,12 +8,16 @@ namespace ignis
 {
 
 
-template<typename pT>
-class _particleHandler : public Event<pT>
+template<typename pT, uint D>
+class _particleHandler : public Event<pT, D>
 {
 public:
 
-    _particleHandler(MainMesh<pT> *mm) : Event<pT>("particleHandler"), mm(mm) {}
+    _particleHandler(MainMesh<pT, D> *mm) : Event<pT, D>("particleHandler"), mm(mm)
+    {
+        this->declareAccess(IGNIS_POSITIONS | IGNIS_TOPOLOGY, IGNIS_CONTAINMENT);
+        this->setResetFree();
+    }
 
     void initialize()
     {
@@ -25,24 +29,34 @@ public:
 
     void execute()
     {
-        mm->_updateContainments();
+        if (!mm->m_instrumentation.enabled())
+        {
+            mm->_updateContainments();
+            return;
+        }
+
+        mm->m_instrumentation.updateContainments([this] () {mm->_updateContainments();});
     }
 
 private:
 
-    MainMesh<pT> *mm;
+    MainMesh<pT, D> *mm;
 
 };
 
-template<typename pT>
-class _reportProgress : public Event<pT>
+template<typename pT, uint D>
+class _reportProgress : public Event<pT, D>
 {
 public:
 
-    using Event<pT>::loopCycle;
-    using Event<pT>::m_nCycles;
+    using Event<pT, D>::loopCycle;
+    using Event<pT, D>::m_nCycles;
 
-    _reportProgress() : Event<pT>("Progress", "%", true) {}
+    _reportProgress() : Event<pT, D>("Progress", "%", true)
+    {
+        this->declareAccess(0, 0);
+        this->setResetFree();
+    }
 
     void execute()
     {
@@ -50,51 +64,54 @@ public:
     }
 };
 
-template<typename pT>
-class _dumpEvents : public Event<pT>
+template<typename pT, uint D>
+class _dumpEvents : public Event<pT, D>
 {
 public:
 
-    _dumpEvents(MainMesh<pT> *mm) : Event<pT>("INTRINSIC_EVENT_DUMP"), mm(mm) {}
+    _dumpEvents(MainMesh<pT, D> *mm) : Event<pT, D>("INTRINSIC_EVENT_DUMP"), mm(mm)
+    {
+        this->setResetFree();
+    }
 
+    //! Runs every outputSpacing cycles (see Event::setPeriod).
     void execute()
     {
-        if (this->m_cycle%mm->outputSpacing() == 0)
-        {
-            mm->dumpEvents();
-        }
+        mm->dumpEvents();
     }
 
 private:
 
-    MainMesh<pT> *mm;
+    MainMesh<pT, D> *mm;
 
 };
 
-template<typename pT>
-class _dumpEventsToFile : public Event<pT>
+template<typename pT, uint D>
+class _dumpEventsToFile : public Event<pT, D>
 {
 public:
 
-    _dumpEventsToFile(MainMesh<pT>* mm) : Event<pT>("INTRINSIC_EVENT_FILEDUMP"), m_mm(mm) {}
+    _dumpEventsToFile(MainMesh<pT, D>* mm) : Event<pT, D>("INTRINSIC_EVENT_FILEDUMP"), m_mm(mm)
+    {
+        this->setResetFree();
+    }
 
     void initialize()
     {
-        m_mm->_initializeEventStorage(this->m_nCycles/m_mm->saveValuesSpacing());
+        const uint spacing = m_mm->saveValuesSpacing();
+
+        m_mm->_initializeEventStorage((this->m_nCycles + spacing - 1)/spacing);
     }
 
+    //! Runs every saveValuesSpacing cycles (see Event::setPeriod).
     void execute()
     {
-        if (this->loopCycle()%m_mm->saveValuesSpacing() == 0)
-        {
-            m_mm->_storeEventValues(this->loopCycle()/m_mm->saveValuesSpacing());
-        }
-
+        m_mm->_storeEventValues();
     }
 
 private:
 
-    MainMesh<pT> *m_mm;
+    MainMesh<pT, D> *m_mm;
 
 };
 
@@ -2,34 +2,48 @@
 
 #include "intrinsicevents.h"
 
+#include "containmentgrid.h"
+
+#include "containmenttracker.h"
+
+#include "../boxkernel.h"
+
 #include <iomanip>
+#include <set>
+#include <queue>
+#include <unordered_map>
+#include <numeric>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace ignis;
 
 
-template<typename pT>
-MainMesh<pT>::MainMesh() :
-    MeshField<pT>(std::string("MainMesh"))
+template<typename pT, uint D>
+MainMesh<pT, D>::MainMesh() :
+    MeshField<pT, D>(std::string("MainMesh"))
 {
     onConstruct();
 }
 
-template<typename pT>
-MainMesh<pT>::MainMesh(const Mat<pT> &topology) :
-    MeshField<pT>(topology, "MainMesh")
+template<typename pT, uint D>
+MainMesh<pT, D>::MainMesh(const Mat<pT> &topology) :
+    MeshField<pT, D>(topology, "MainMesh")
 {
     onConstruct();
 }
 
-template<typename pT>
-MainMesh<pT>::MainMesh(const std::initializer_list<pT> topology) :
-    MeshField<pT>(topology, "MainMesh")
+template<typename pT, uint D>
+MainMesh<pT, D>::MainMesh(const std::initializer_list<pT> topology) :
+    MeshField<pT, D>(topology, "MainMesh")
 {
     onConstruct();
 }
 
-template<typename pT>
-MainMesh<pT>::~MainMesh()
+template<typename pT, uint D>
+MainMesh<pT, D>::~MainMesh()
 {
     if (!m_finalized)
     {
@@ -37,10 +51,26 @@ MainMesh<pT>::~MainMesh()
     }
 
     delete m_loopCycle;
+
+    delete m_containmentGrid;
+
+    delete m_containmentTracker;
+
+    delete m_eventPool;
+
+    delete m_instrumentation.m_profiler;
+
+    delete m_instrumentation.m_tracer;
+
+    delete m_reporter;
+
+    delete [] m_eventValues;
+
+    delete [] m_eventValueFlags;
 }
 
-template<typename pT>
-void MainMesh<pT>::onConstruct()
+template<typename pT, uint D>
+void MainMesh<pT, D>::onConstruct()
 {
     m_loopCycle = new uint(0);
 
@@ -56,23 +86,244 @@ void MainMesh<pT>::onConstruct()
 
     m_reportProgress = false;
 
+    m_useSpatialIndex = false;
+
+    m_containmentGrid = nullptr;
+
+    m_useIncrementalContainment = false;
+
+    m_containmentTracker = nullptr;
+
+    m_containmentThreads = 1;
+
+    m_eventPool = nullptr;
+
+    m_groupEventsByField = false;
+
+    m_seed = 0;
+    m_nextStream = 0;
+
+    m_reporter = nullptr;
+
+    m_eventValues = nullptr;
+
+    m_eventValueFlags = nullptr;
+
+    m_nStoredRows = 0;
+
+    m_stop = false;
+
+    m_terminate = false;
+
+    m_currentChunkIndex = 0;
+
+    m_nCycles = 0;
+
+    m_runtimeExpiry = IGNIS_UNSET_UINT;
+
+    m_nextCycle = 0;
+
+    m_executing = false;
+    m_executingInParallel = false;
+
     setOutputPath("/tmp/");
 
     m_handleParticles = (m_currentParticles != nullptr);
 
 }
 
-template<typename pT>
-uint MainMesh<pT>::getPopulation() const
+template<typename pT, uint D>
+uint MainMesh<pT, D>::getPopulation() const
+{
+    return MeshField<pT, D>::totalNumberOfParticles();
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::enableSpatialIndex(const bool state, const uint cellsPerDimension)
+{
+    m_useSpatialIndex = state;
+
+    delete m_containmentGrid;
+    m_containmentGrid = nullptr;
+
+    if (state)
+    {
+        m_containmentGrid = new ContainmentGrid<pT, D>(this, cellsPerDimension);
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::enableIncrementalContainment(const bool state, const double skin)
+{
+    m_useIncrementalContainment = state;
+
+    delete m_containmentTracker;
+    m_containmentTracker = nullptr;
+
+    if (state)
+    {
+        m_containmentTracker = new ContainmentTracker<pT, D>(this, skin);
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::setContainmentThreads(const uint nThreads)
+{
+    BADAss(nThreads, !=, 0, "At least one containment thread is required.");
+
+    m_containmentThreads = nThreads;
+
+#ifndef _OPENMP
+    if (nThreads != 1)
+    {
+        cerr << "warning: ignis is built without OpenMP. Containments are updated serially." << endl;
+    }
+#endif
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_trackFaces(const MeshField<pT, D> *field, const pT margin, std::vector<uint> *nearFace)
+{
+    BADAss(margin, >=, 0, "The face margin cannot be negative.");
+
+    _untrackFaces(nearFace);
+
+    _resetNearFaces(*nearFace);
+
+    m_faceTrackers.push_back({field, margin, nearFace});
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_resetNearFaces(std::vector<uint> &nearFace) const
+{
+    //Nothing is known until the next containment update, so every particle counts.
+    nearFace.resize(this->m_particles == nullptr ? 0 : this->m_particles->count());
+
+    std::iota(nearFace.begin(), nearFace.end(), 0);
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_untrackFaces(const std::vector<uint> *nearFace)
+{
+    m_faceTrackers.erase(std::remove_if(m_faceTrackers.begin(),
+                                        m_faceTrackers.end(),
+                                        [nearFace] (const FaceTracker &tracker) {return tracker.m_nearFace == nearFace;}),
+                         m_faceTrackers.end());
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::setEventThreads(const uint nThreads)
+{
+    BADAss(nThreads, !=, 0, "At least one event thread is required.");
+    BADAssBool(m_finalized, "Event threads cannot be changed during an event loop.");
+
+    delete m_eventPool;
+    m_eventPool = nullptr;
+
+    if (nThreads > 1)
+    {
+        m_eventPool = new WorkStealingPool(nThreads);
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::enableProfiling(const bool state, const std::string &name)
+{
+    BADAssBool(m_finalized, "Profiling cannot be toggled during an event loop.");
+
+    delete m_instrumentation.m_profiler;
+    m_instrumentation.m_profiler = nullptr;
+
+    if (state)
+    {
+        m_instrumentation.m_profiler = new EventProfiler<pT, D>();
+        m_profileName = name;
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::enableAsyncOutput(const bool state, const uint capacity, std::ostream &out)
+{
+    BADAssBool(m_finalized, "Output cannot be changed during an event loop.");
+
+    delete m_reporter;
+    m_reporter = nullptr;
+
+    m_reportSources.clear();
+
+    if (state)
+    {
+        m_reporter = new AsyncReporter(out, capacity);
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_registerReportSource(const Event<pT, D> *event)
 {
-    return MeshField<pT>::totalNumberOfParticles();
+    if (!event->hasOutput() || m_reportSources.find(event) != m_reportSources.end())
+    {
+        return;
+    }
+
+    m_reportSources[event] = m_reporter->registerSource(event->type(), event->meshField().description(), event->unit());
 }
 
-template<typename pT>
-void MainMesh<pT>::_updateContainments()
+template<typename pT, uint D>
+void MainMesh<pT, D>::enableTracing(const bool state, const uint sampleInterval, const uint maxRecords, const std::string &name)
 {
+    BADAssBool(m_finalized, "Tracing cannot be toggled during an event loop.");
+
+    delete m_instrumentation.m_tracer;
+    m_instrumentation.m_tracer = nullptr;
+
+    m_eventStorageFile.setWriteListener(IgnWriter::WriteListener());
+
+    if (state)
+    {
+        EventTracer<pT, D> *tracer = new EventTracer<pT, D>(sampleInterval, maxRecords);
+
+        m_instrumentation.m_tracer = tracer;
+        m_traceName = name;
+
+        m_eventStorageFile.setWriteListener([tracer] (const uint64_t nValues, const std::chrono::steady_clock::time_point start)
+        {
+            tracer->recordWrite(nValues, start);
+        });
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_updateContainments()
+{
+    if (!m_faceTrackers.empty())
+    {
+        _updateFaceTrackers();
+    }
+
+    if (m_useIncrementalContainment && m_containmentTracker->update())
+    {
+        return;
+    }
 
-    for (MeshField<pT> *subField : this->m_subFields)
+    if (m_containmentThreads > 1)
+    {
+        _updateContainmentsFlattened();
+        return;
+    }
+
+    if (m_useSpatialIndex)
+    {
+        m_containmentGrid->fill();
+        return;
+    }
+
+    if (this->m_particles->span().valid())
+    {
+        _updateContainmentsFlattened();
+        return;
+    }
+
+    for (MeshField<pT, D> *subField : this->m_subFields)
     {
         subField->resetSubFields();
     }
@@ -80,7 +331,7 @@ void MainMesh<pT>::_updateContainments()
     for (uint i = 0; i < this->m_particles->count(); ++i)
     {
 
-        for (MeshField<pT> *subField : this->m_subFields)
+        for (MeshField<pT, D> *subField : this->m_subFields)
         {
             (void)subField->checkSubFields(i);
         }
@@ -89,8 +340,231 @@ void MainMesh<pT>::_updateContainments()
 
 }
 
-template<typename pT>
-void MainMesh<pT>::finalize()
+template<typename pT, uint D>
+void MainMesh<pT, D>::_binParticle(const uint i, std::vector<std::vector<uint> *> &targets) const
+{
+    for (uint f = 0; f < m_flatFields.size(); ++f)
+    {
+        if (m_flatFields[f]->isWithinThis(i))
+        {
+            ContainmentGrid<pT, D>::appendToChain(m_flatParents, f, i, targets);
+        }
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_binBlock(const PositionSpan<pT, D> &positions,
+                             const uint first,
+                             const uint n,
+                             std::vector<uint64_t> &masks,
+                             std::vector<std::vector<uint> *> &targets) const
+{
+    const uint nFields = m_flatFields.size();
+
+    for (uint f = 0; f < nFields; ++f)
+    {
+        MeshField<pT, D> *field = m_flatFields[f];
+
+        if (field->hasCustomGeometry())
+        {
+            masks[f] = 0;
+
+            for (uint k = 0; k < n; ++k)
+            {
+                masks[f] |= (uint64_t)field->isWithinThis(first + k) << k;
+            }
+        }
+
+        else
+        {
+            masks[f] = boxMask(positions, field->topology.memptr(), field->topology.memptr() + D, first, n);
+        }
+    }
+
+    //Children follow their parents in the flattened order.
+    for (uint f = nFields; f-- > 0;)
+    {
+        if (m_flatParents[f] != IGNIS_UNSET_UINT)
+        {
+            masks[m_flatParents[f]] |= masks[f];
+        }
+    }
+
+    for (uint f = 0; f < nFields; ++f)
+    {
+        appendMaskedIndices(masks[f], first, *targets[f]);
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_updateContainmentsFlattened()
+{
+    if (m_useSpatialIndex)
+    {
+        m_containmentGrid->prepare();
+
+        m_flatFields = m_containmentGrid->fields();
+        m_flatParents = m_containmentGrid->parents();
+    }
+
+    else
+    {
+        m_flatFields.clear();
+        m_flatParents.clear();
+
+        this->_flattenSubFields(m_flatFields, m_flatParents);
+    }
+
+    const uint nFields = m_flatFields.size();
+    const uint nParticles = this->m_particles->count();
+
+    const PositionSpan<pT, D> positions = this->m_particles->span();
+
+    m_threadAtoms.resize(m_containmentThreads);
+
+    for (std::vector<std::vector<uint> > &atoms : m_threadAtoms)
+    {
+        atoms.resize(nFields);
+    }
+
+    uint nThreadsUsed = 1;
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(m_containmentThreads)
+#endif
+    {
+        uint thread = 0;
+        uint nThreads = 1;
+
+#ifdef _OPENMP
+        thread = omp_get_thread_num();
+        nThreads = omp_get_num_threads();
+#endif
+
+#ifdef _OPENMP
+#pragma omp single
+#endif
+        nThreadsUsed = nThreads;
+
+        //Contiguous particle ranges keep the merged atom lists sorted.
+        const uint first = (unsigned long)nParticles*thread/nThreads;
+        const uint last = (unsigned long)nParticles*(thread + 1)/nThreads;
+
+        std::vector<std::vector<uint> *> targets(nFields);
+
+        for (uint f = 0; f < nFields; ++f)
+        {
+            m_threadAtoms[thread][f].clear();
+            targets[f] = &m_threadAtoms[thread][f];
+        }
+
+        if (m_useSpatialIndex)
+        {
+            for (uint i = first; i < last; ++i)
+            {
+                m_containmentGrid->bin(i, targets);
+            }
+        }
+
+        else if (positions.valid())
+        {
+            std::vector<uint64_t> masks(nFields);
+
+            for (uint block = first; block < last; block += IGNIS_BOX_BLOCK)
+            {
+                _binBlock(positions, block, std::min(IGNIS_BOX_BLOCK, last - block), masks, targets);
+            }
+        }
+
+        else
+        {
+            for (uint i = first; i < last; ++i)
+            {
+                _binParticle(i, targets);
+            }
+        }
+
+#ifdef _OPENMP
+#pragma omp barrier
+
+#pragma omp for schedule(dynamic)
+#endif
+        for (uint f = 0; f < nFields; ++f)
+        {
+            std::vector<uint> &atoms = m_flatFields[f]->m_atoms;
+
+            uint size = 0;
+            for (uint t = 0; t < nThreadsUsed; ++t)
+            {
+                size += m_threadAtoms[t][f].size();
+            }
+
+            atoms.clear();
+            atoms.reserve(size);
+
+            for (uint t = 0; t < nThreadsUsed; ++t)
+            {
+                atoms.insert(atoms.end(), m_threadAtoms[t][f].begin(), m_threadAtoms[t][f].end());
+            }
+        }
+    }
+
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_updateFaceTrackers()
+{
+    const PositionHandler<pT, D> &particles = *this->m_particles;
+    const PositionSpan<pT, D> positions = this->m_particles->span();
+    const uint nParticles = particles.count();
+
+    for (const FaceTracker &tracker : m_faceTrackers)
+    {
+        pT low[D];
+        pT high[D];
+
+        for (uint d = 0; d < D; ++d)
+        {
+            low[d] = tracker.m_field->topology(d, 0) + tracker.m_margin;
+            high[d] = tracker.m_field->topology(d, 1) - tracker.m_margin;
+        }
+
+        std::vector<uint> &nearFace = *tracker.m_nearFace;
+
+        nearFace.clear();
+
+        if (positions.valid())
+        {
+            for (uint block = 0; block < nParticles; block += IGNIS_BOX_BLOCK)
+            {
+                const uint n = std::min(IGNIS_BOX_BLOCK, nParticles - block);
+                const uint64_t all = ~uint64_t(0) >> (64 - n);
+
+                appendMaskedIndices(~boxMask(positions, low, high, block, n) & all, block, nearFace);
+            }
+
+            continue;
+        }
+
+        for (uint i = 0; i < nParticles; ++i)
+        {
+            bool inside = true;
+
+            for (uint d = 0; d < D; ++d)
+            {
+                inside = inside && particles(i, d) >= low[d] && particles(i, d) <= high[d];
+            }
+
+            if (!inside)
+            {
+                nearFace.push_back(i);
+            }
+        }
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::finalize()
 {
 
     if (m_finalized)
@@ -99,13 +573,15 @@ void MainMesh<pT>::finalize()
         return;
     }
 
-    for (Event<pT> *event : m_allEvents)
+    for (Event<pT, D> *event : m_allEvents)
     {
         event->markAsInitialized(false);
         event->resetSetTimes();
     }
 
-    for (Event<pT> *intrinsicEvent : m_intrinsicEvents)
+    _unbindEventValues();
+
+    for (Event<pT, D> *intrinsicEvent : m_intrinsicEvents)
     {
         this->removeEvent(intrinsicEvent);
         delete intrinsicEvent;
@@ -114,62 +590,216 @@ void MainMesh<pT>::finalize()
     m_intrinsicEvents.clear();
 
 
-    for (LoopChunk *lc : m_allLoopChunks)
-    {
-        delete lc;
-    }
-
     m_allLoopChunks.clear();
 
+    m_chunkEvents.clear();
+
+    m_plan.m_events.clear();
+
+    m_pendingEvents.clear();
+
+    m_runtimeEvents.clear();
+
+    m_runtimeExpiry = IGNIS_UNSET_UINT;
+
+    m_retiredEvents.clear();
+
     m_allEvents.clear();
 
 
     m_storageEnabledEvents.clear();
 
-    if (m_eventStorageFile.is_open())
+    _finalizeEventStorage();
+
+    if (m_instrumentation.m_profiler != nullptr)
+    {
+        m_instrumentation.m_profiler->report(m_outputPath + m_profileName);
+    }
+
+    if (m_instrumentation.m_tracer != nullptr)
+    {
+        m_instrumentation.m_tracer->write(m_outputPath + m_traceName + ".json");
+    }
+
+    if (m_reporter != nullptr)
     {
-        m_eventStorageFile.close();
+        m_reporter->flush();
     }
 
     m_finalized = true;
 
 }
 
-template<typename pT>
-void MainMesh<pT>::removeEventFromChunks(Event<pT> *event)
+template<typename pT, uint D>
+void MainMesh<pT, D>::removeEventFromChunks(Event<pT, D> *event)
 {
+    //A later event may be allocated at the same address.
+    m_reportSources.erase(event);
+
     if (!m_stop)
     {
         return;
     }
 
-    for (uint chunkIndex = m_currentChunkIndex; chunkIndex < m_allLoopChunks.size(); ++chunkIndex)
+    _removeEvent(event);
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::insertEvent(Event<pT, D> *event, const uint onset, const uint length, MeshField<pT, D> *field)
+{
+    BADAssBool(!m_finalized, "Events can only be inserted while the loop runs. Use addEvent instead.");
+    BADAssBool(!event->storeValue(), "Runtime events cannot store values.", [&] ()
+    {
+        BADAssSimpleDump(event->description());
+    });
+    BADAss(length, !=, 0);
+    BADAss(event->period(), ==, 1, "Runtime events cannot be periodic.");
+
+    //Concurrent insertions would be numbered in the order the threads arrive. This
+    //may run on a pool worker, where an exception would not reach the caller.
+    if (m_executingInParallel)
     {
-        LoopChunk *chunk = m_allLoopChunks.at(chunkIndex);
-        std::vector<Event<pT>*> &ev = chunk->m_events;
+        cerr << "ignis::insertEvent: " << event->description()
+             << " was inserted from a cycle running on several event threads." << endl;
+        exit(1);
+    }
+
+    std::lock_guard<std::mutex> lock(m_scheduleMutex);
+
+    const uint start = m_nextCycle + onset;
+
+    BADAss(start, <, m_nCycles, "Runtime event starts after the loop has ended.");
+
+    if (field == nullptr)
+    {
+        field = this;
+    }
 
-        ev.erase( std::remove( ev.begin(), ev.end(), event ), ev.end() );
+    field->addEvent(event);
+
+    event->setOnsetTime(start);
+
+    if (length != IGNIS_UNSET_UINT)
+    {
+        event->setOffsetTime(std::min(start + length - 1, m_nCycles - 1));
+    }
+
+    field->_prepareEvent(event, m_nCycles, m_loopCycle);
+
+    event->_resolveDependencies();
+
+    event->_setRandomStream(RandomStream(m_seed, m_nextStream++));
+
+    m_pendingEvents.push_back({start, event});
+    std::push_heap(m_pendingEvents.begin(), m_pendingEvents.end(), std::greater<PendingEvent>());
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::retireEvent(Event<pT, D> *event)
+{
+    BADAssBool(!m_finalized, "Events can only be retired while the loop runs. Use removeEvent instead.");
+
+    if (m_executing)
+    {
+        std::lock_guard<std::mutex> lock(m_scheduleMutex);
+
+        m_retiredEvents.push_back(event);
+        return;
+    }
+
+    //A stopped loop removes the event from the schedule through removeEventFromChunks.
+    if (!m_stop)
+    {
+        _removeEvent(event);
+    }
+
+    event->meshField().removeEvent(event);
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_removeEvent(Event<pT, D> *event)
+{
+    //The event may be deleted once removed.
+    event->_unbindValue();
+    m_reportSources.erase(event);
+
+    //Linear in the number of events, like the erases below. Retiring is rare
+    //compared to executing, which keeps its contiguous lists.
+    const auto top = std::find(m_allEvents.begin(), m_allEvents.end(), event);
+
+    if (top != m_allEvents.end())
+    {
+        m_allEvents.erase(top);
+    }
+
+    const auto runtime = std::find(m_runtimeEvents.begin(), m_runtimeEvents.end(), event);
+
+    if (runtime != m_runtimeEvents.end())
+    {
+        m_runtimeEvents.erase(runtime);
+        return;
+    }
+
+    const auto pending = std::find_if(m_pendingEvents.begin(),
+                                      m_pendingEvents.end(),
+                                      [event] (const PendingEvent &p) {return p.m_event == event;});
+
+    if (pending != m_pendingEvents.end())
+    {
+        m_pendingEvents.erase(pending);
+        std::make_heap(m_pendingEvents.begin(), m_pendingEvents.end(), std::greater<PendingEvent>());
+        return;
+    }
+
+    //Only chunks from the current one which overlap [onset, offset] can hold the event.
+    const auto begin = m_allLoopChunks.begin() + std::min<uint>(m_currentChunkIndex, m_allLoopChunks.size());
+
+    const auto first = std::lower_bound(begin, m_allLoopChunks.end(), event->onsetTime(),
+                                        [] (const LoopChunk &chunk, const uint cycle) {return chunk.m_end < cycle;});
+
+    const auto last = std::upper_bound(first, m_allLoopChunks.end(), event->offsetTime(),
+                                       [] (const uint cycle, const LoopChunk &chunk) {return cycle < chunk.m_start;});
+
+    bool currentChanged = false;
+
+    for (auto chunk = first; chunk != last; ++chunk)
+    {
+        //The chunk keeps its slots, so later chunks stay where they are.
+        Event<pT, D> **chunkFirst = m_chunkEvents.data() + chunk->m_firstEvent;
+        Event<pT, D> **chunkLast = chunkFirst + chunk->m_nEvents;
+
+        chunk->m_nEvents = std::remove(chunkFirst, chunkLast, event) - chunkFirst;
+
+        currentChanged = currentChanged || (&*chunk == m_currentChunk);
 
 #ifndef NDEBUG
-        for (Event<pT> *remainingEvent : ev)
+        for (uint i = 0; i < chunk->m_nEvents; ++i)
         {
-            BADAssBool(!remainingEvent->dependsOn(event), "Removing event which the remaining events depend on. Check your order or removal.");
+            BADAssBool(!chunkFirst[i]->dependsOn(event), "Removing event which the remaining events depend on. Check your order or removal.");
         }
 #endif
     }
+
+    if (currentChanged)
+    {
+        _compilePlan();
+        _scheduleChunk(m_nextCycle);
+    }
 }
 
-template<typename pT>
-void MainMesh<pT>::dumpLoopChunkInfo()
+template<typename pT, uint D>
+void MainMesh<pT, D>::dumpLoopChunkInfo()
 {
 
     using namespace std;
 
-    for (LoopChunk * loopChunk : m_allLoopChunks) {
+    for (const LoopChunk &loopChunk : m_allLoopChunks) {
+
+        cout << "Loopchunk interval: [" << loopChunk.m_start << " " << loopChunk.m_end << "]" << endl;
+        cout << "has " << loopChunk.m_nEvents << " events: " << endl;
+        for (uint i = 0; i < loopChunk.m_nEvents; ++i) {
+            const Event<pT, D> *event = m_chunkEvents.at(loopChunk.m_firstEvent + i);
 
-        cout << "Loopchunk interval: [" << loopChunk->m_start << " " << loopChunk->m_end << "]" << endl;
-        cout << "has " << loopChunk->m_events.size() << " events: " << endl;
-        for (Event<pT>* event : loopChunk->m_events) {
             cout << "  " << setw(2) << right << event->priority() << "  "
                  << setw(30) << left << event->type()
                  << "["
@@ -182,43 +812,81 @@ void MainMesh<pT>::dumpLoopChunkInfo()
     }
 }
 
-template<typename pT>
-void MainMesh<pT>::_streamValueToFile(const double value)
+template<typename pT, uint D>
+void MainMesh<pT, D>::_storeEventValues()
 {
-    BADAssBool(m_eventStorageFile.is_open(), "event file is not open but asked to write.");
+    const uint index = m_nStoredRows;
 
-    m_eventStorageFile.write(reinterpret_cast<const char*>(&value), sizeof(double));
-}
+    //The stored values are the leading slots of m_eventValues.
+    const double *values = m_eventValues;
 
-template<typename pT>
-void MainMesh<pT>::_storeEventValues(const uint index)
-{
-    for (uint i = 0; i < numberOfStoredEvents(); ++i)
+    if (m_storeEvents)
     {
-        const double &value = m_storageEnabledEvents.at(i)->value();
-
-        if (m_storeEvents)
+        for (uint i = 0; i < numberOfStoredEvents(); ++i)
         {
-            m_storedEventValues(index, i) = value;
+            m_storedEventValues(index, i) = values[i];
         }
+    }
+
+    if (m_storeEventsToFile)
+    {
+        BADAssBool(m_eventStorageFile.isOpen(), "event file is not open but asked to write.");
 
-        if (m_storeEventsToFile)
+        m_eventStorageFile.write(values, numberOfStoredEvents());
+        m_eventStorageFile.endRow();
+    }
+
+    m_nStoredRows++;
+
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_bindEventValues()
+{
+    std::vector<Event<pT, D> *> events = m_storageEnabledEvents;
+
+    for (Event<pT, D> *event : m_allEvents)
+    {
+        if (!event->storeValue())
         {
-            this->_streamValueToFile(value);
+            events.push_back(event);
         }
+    }
+
+    delete [] m_eventValues;
+    delete [] m_eventValueFlags;
+
+    //Never resized during the loop, so the events can point into them.
+    m_eventValues = new double[events.size()];
+    m_eventValueFlags = new bool[events.size()];
 
+    for (uint i = 0; i < events.size(); ++i)
+    {
+        events[i]->_bindValue(m_eventValues + i, m_eventValueFlags + i);
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_unbindEventValues()
+{
+    for (Event<pT, D> *event : m_allEvents)
+    {
+        event->_unbindValue();
     }
 
-    m_eventStorageFile.flush();
+    delete [] m_eventValues;
+    delete [] m_eventValueFlags;
 
+    m_eventValues = nullptr;
+    m_eventValueFlags = nullptr;
 }
 
 
-template<typename pT>
-void MainMesh<pT>::_initializeEventStorage(const uint size)
+template<typename pT, uint D>
+void MainMesh<pT, D>::_initializeEventStorage(const uint size)
 {
-    std::stringstream typeHeader;
-    Event<pT> *event;
+    IgnHeader header;
+    Event<pT, D> *event;
 
     m_storedEventTypes.clear();
     for (uint i = 0; i < m_storageEnabledEvents.size(); ++i)
@@ -227,40 +895,61 @@ void MainMesh<pT>::_initializeEventStorage(const uint size)
 
         m_storedEventTypes.push_back(event->type() + ("@" + event->meshField().description()));
 
-        typeHeader << m_storedEventTypes.back();
+        header.m_columnNames.push_back(m_storedEventTypes.back());
+        header.m_units.push_back(event->unit());
+    }
 
-        if (i == m_storageEnabledEvents.size() - 1)
-        {
-            typeHeader << "\n";
-        }
-        else
+    m_nStoredRows = 0;
+
+    if (m_storeEvents)
+    {
+        m_storedEventValues.zeros(size, numberOfStoredEvents());
+    }
+
+    if (m_storeEventsToFile)
+    {
+        BADAssBool(!m_eventStorageFile.isOpen());
+
+        m_eventStorageFile.open(m_outputPath + m_filename, header.nCols());
+
+        header.m_spacing = m_saveValuesSpacing;
+
+        if (m_eventStorageFile.compressed())
         {
-            typeHeader << " ";
+            header.m_flags |= IgnHeader::Compressed;
         }
-    }
 
-    if (m_storeEvents)
-    {
-        m_storedEventValues.zeros(size, numberOfStoredEvents());
+        const std::string headerBytes = header.serialize();
+
+        m_eventStorageFile.writeRaw(headerBytes.c_str(), headerBytes.size());
+
     }
+}
 
-    if (m_storeEventsToFile)
+template<typename pT, uint D>
+void MainMesh<pT, D>::_finalizeEventStorage()
+{
+    if (!m_eventStorageFile.isOpen())
     {
-        BADAssBool(!m_eventStorageFile.is_open());
+        return;
+    }
 
-        m_eventStorageFile.open(m_outputPath + m_filename, std::ios::binary);
+    const uint64_t nRows = m_nStoredRows;
 
-        uint nCols = m_storageEnabledEvents.size();
+    m_eventStorageFile.patch(IgnHeader::nRowsOffset, reinterpret_cast<const char*>(&nRows), sizeof(uint64_t));
 
-        m_eventStorageFile.write(typeHeader.str().c_str(), typeHeader.tellp());
-        m_eventStorageFile.write(reinterpret_cast<const char*>(&size), sizeof(uint));
-        m_eventStorageFile.write(reinterpret_cast<const char*>(&nCols), sizeof(uint));
+    if (m_eventStorageFile.compressed())
+    {
+        const uint64_t indexOffset = m_eventStorageFile.writeBlockIndex();
 
+        m_eventStorageFile.patch(IgnHeader::indexOffsetOffset, reinterpret_cast<const char*>(&indexOffset), sizeof(uint64_t));
     }
+
+    m_eventStorageFile.close();
 }
 
-template<typename pT>
-void MainMesh<pT>::eventLoop(const uint nCycles)
+template<typename pT, uint D>
+void MainMesh<pT, D>::eventLoop(const uint nCycles)
 {
     BADAss(nCycles, !=, 0l, "Zero cycles is not allowed. Call initialize manually or add an event which terminate mainloop in initialization instead.");
 
@@ -282,16 +971,51 @@ void MainMesh<pT>::eventLoop(const uint nCycles)
 
     *m_loopCycle = 0;
 
+    m_nCycles = nCycles;
+
+    m_nextCycle = 0;
+
     m_finalized = false;
 
+    if (m_instrumentation.m_profiler != nullptr)
+    {
+        m_instrumentation.m_profiler->setWorkers(eventThreads());
+        m_instrumentation.m_profiler->clear();
+    }
+
+    if (m_instrumentation.m_tracer != nullptr)
+    {
+        m_instrumentation.m_tracer->start(eventThreads());
+    }
+
     _addIntrinsicEvents();
 
+    //Particles may have moved since the last loop.
+    for (const FaceTracker &tracker : m_faceTrackers)
+    {
+        _resetNearFaces(*tracker.m_nearFace);
+    }
+
     this->_prepareEvents(nCycles, m_loopCycle);
 
     _sortEvents();
 
+    //Streams are numbered in the sorted order of the non-intrinsic events, so they
+    //depend neither on other meshes' events nor on the output settings.
+    m_nextStream = 0;
+
+    for (Event<pT, D> *event : m_allEvents)
+    {
+        if (std::find(m_intrinsicEvents.begin(), m_intrinsicEvents.end(), event) == m_intrinsicEvents.end())
+        {
+            event->_setRandomStream(RandomStream(m_seed, m_nextStream++));
+        }
+    }
+
     _setupChunks();
 
+    _bindEventValues();
+
     m_stop = false;
     m_terminate = false;
 
@@ -299,16 +1023,16 @@ void MainMesh<pT>::eventLoop(const uint nCycles)
 
 }
 
-template<typename pT>
-void MainMesh<pT>::runChunks()
+template<typename pT, uint D>
+void MainMesh<pT, D>::runChunks()
 {
     BADAssBool(!m_allLoopChunks.empty());
 
     runChunks(0);
 }
 
-template<typename pT>
-void MainMesh<pT>::runChunks(const uint start)
+template<typename pT, uint D>
+void MainMesh<pT, D>::runChunks(const uint start)
 {
     if (m_stop || m_terminate)
     {
@@ -317,7 +1041,9 @@ void MainMesh<pT>::runChunks(const uint start)
 
     for (m_currentChunkIndex = start; m_currentChunkIndex < m_allLoopChunks.size(); ++m_currentChunkIndex)
     {
-        m_currentChunk = m_allLoopChunks.at(m_currentChunkIndex);
+        m_currentChunk = &m_allLoopChunks.at(m_currentChunkIndex);
+
+        _compilePlan();
 
         _initializeNewEvents();
 
@@ -338,19 +1064,23 @@ void MainMesh<pT>::runChunks(const uint start)
     finalize();
 }
 
-template<typename pT>
-void MainMesh<pT>::runCurrentChunk()
+template<typename pT, uint D>
+void MainMesh<pT, D>::runCurrentChunk()
 {
     runCurrentChunk(m_currentChunk->m_start);
 }
 
-template<typename pT>
-void MainMesh<pT>::runCurrentChunk(const uint start)
+template<typename pT, uint D>
+void MainMesh<pT, D>::runCurrentChunk(const uint start)
 {
     BADAss(start, >=, m_currentChunk->m_start);
 
     m_chunkStarted = true;
 
+    const auto chunkStart = std::chrono::steady_clock::now();
+
+    _scheduleChunk(start);
+
     for (*m_loopCycle = start; *m_loopCycle <= m_currentChunk->m_end; ++(*m_loopCycle))
     {
         _executeEvents();
@@ -360,10 +1090,15 @@ void MainMesh<pT>::runCurrentChunk(const uint start)
             break;
         }
     }
+
+    if (m_instrumentation.m_tracer != nullptr)
+    {
+        m_instrumentation.m_tracer->recordChunk(start, std::min(*m_loopCycle, m_currentChunk->m_end), chunkStart);
+    }
 }
 
-template<typename pT>
-bool MainMesh<pT>::endChunk()
+template<typename pT, uint D>
+bool MainMesh<pT, D>::endChunk()
 {
     if (m_stop)
     {
@@ -380,8 +1115,8 @@ bool MainMesh<pT>::endChunk()
     return false;
 }
 
-template<typename pT>
-void MainMesh<pT>::reConnect()
+template<typename pT, uint D>
+void MainMesh<pT, D>::reConnect()
 {
     BADAssBool(m_stop);
     m_stop = false;
@@ -400,8 +1135,8 @@ void MainMesh<pT>::reConnect()
     runChunks(m_currentChunkIndex + 1);
 }
 
-template<typename pT>
-void MainMesh<pT>::setOutputPath(std::string path)
+template<typename pT, uint D>
+void MainMesh<pT, D>::setOutputPath(std::string path)
 {
     if (strcmp(&path.back(), "/") != 0){
         path = path + "/";
@@ -410,8 +1145,8 @@ void MainMesh<pT>::setOutputPath(std::string path)
     m_outputPath = path;
 }
 
-template<typename pT>
-void MainMesh<pT>::_sendToTop(Event<pT> &event)
+template<typename pT, uint D>
+void MainMesh<pT, D>::_sendToTop(Event<pT, D> &event)
 {
     m_allEvents.push_back(&event);
 
@@ -421,77 +1156,178 @@ void MainMesh<pT>::_sendToTop(Event<pT> &event)
     }
 }
 
-template<typename pT>
-void MainMesh<pT>::_addIntrinsicEvents()
+template<typename pT, uint D>
+void MainMesh<pT, D>::_addIntrinsicEvents()
 {
     if (m_handleParticles)
     {
-        _particleHandler<pT> *_handler = new _particleHandler<pT>(this);
+        _particleHandler<pT, D> *_handler = new _particleHandler<pT, D>(this);
         _handler->setManualPriority();
         this->_addIntrinsicEvent(_handler);
     }
 
     if (m_reportProgress)
     {
-        _reportProgress<pT> *_prog = new _reportProgress<pT>();
+        _reportProgress<pT, D> *_prog = new _reportProgress<pT, D>();
         _prog->setManualPriority();
         this->_addIntrinsicEvent(_prog);
     }
 
     if (m_doOutput)
     {
-        _dumpEvents<pT> *_stdout = new _dumpEvents<pT>(this);
+        _dumpEvents<pT, D> *_stdout = new _dumpEvents<pT, D>(this);
         _stdout->setManualPriority();
+        _stdout->setPeriod(m_outputSpacing);
         this->_addIntrinsicEvent(_stdout);
     }
 
     if (m_storeEvents || m_storeEventsToFile)
     {
-        _dumpEventsToFile<pT> *_fileio = new _dumpEventsToFile<pT>(this);
+        _dumpEventsToFile<pT, D> *_fileio = new _dumpEventsToFile<pT, D>(this);
         _fileio->setManualPriority();
+        _fileio->setPeriod(m_saveValuesSpacing);
         this->_addIntrinsicEvent(_fileio);
     }
 
 }
 
-template<typename pT>
-void MainMesh<pT>::_sortEvents()
+template<typename pT, uint D>
+void MainMesh<pT, D>::_sortEvents()
 {
     std::sort(m_allEvents.begin(),
               m_allEvents.end(),
-              [] (const Event<pT> *e1, const Event<pT> *e2) {return e1->priority() < e2->priority();});
+              [] (const Event<pT, D> *e1, const Event<pT, D> *e2) {return e1->priority() < e2->priority();});
+
+    const uint n = m_allEvents.size();
+
+    std::unordered_map<const Event<pT, D> *, uint> indices;
+
+    for (uint i = 0; i < n; ++i)
+    {
+        indices[m_allEvents[i]] = i;
+    }
+
+    std::vector<std::vector<uint> > successors(n);
+    std::vector<uint> nPredecessors(n, 0);
+
+    for (uint i = 0; i < n; ++i)
+    {
+        m_allEvents[i]->_resolveDependencies();
+
+        for (const auto &dependency_pair: m_allEvents[i]->dependencies())
+        {
+            const auto dependency = indices.find(dependency_pair.second);
+
+            //Dependencies outside the loop impose no order.
+            if (dependency == indices.end())
+            {
+                continue;
+            }
+
+            successors[dependency->second].push_back(i);
+            nPredecessors[i]++;
+        }
+    }
+
+    //Kahn's algorithm, taking the ready event of lowest priority first. Orders which
+    //already respect the dependencies are therefore kept as they are.
+    std::priority_queue<uint, std::vector<uint>, std::greater<uint> > ready;
+
+    for (uint i = 0; i < n; ++i)
+    {
+        if (nPredecessors[i] == 0)
+        {
+            ready.push(i);
+        }
+    }
 
-    for (Event<pT> *event : m_allEvents)
+    std::vector<Event<pT, D> *> sorted;
+    sorted.reserve(n);
+
+    while (!ready.empty())
     {
-        for (const auto &dependency_pair: event->dependencies())
+        const uint i = ready.top();
+        ready.pop();
+
+        sorted.push_back(m_allEvents[i]);
+
+        for (const uint successor : successors[i])
         {
-            const Event<pT> *dependency = dependency_pair.second;
+            if (--nPredecessors[successor] == 0)
+            {
+                ready.push(successor);
+            }
+        }
+    }
+
+    if (sorted.size() != n)
+    {
+        std::stringstream s;
+        s << "Dependency error: cycle among";
 
-            if (dependency->priority() > event->priority())
+        for (uint i = 0; i < n; ++i)
+        {
+            if (nPredecessors[i] != 0)
             {
-                std::stringstream s;
-                s << "Dependency error: "
-                  << event->description()
-                  << " (" << event->priority() << ")"
-                  << " depends on "
-                  << dependency->description()
-                  << " (" << dependency->priority() << ")";
-
-                throw std::logic_error(s.str());
+                s << " " << m_allEvents[i]->description() << " (" << m_allEvents[i]->priority() << ")";
             }
         }
+
+        throw std::logic_error(s.str());
+    }
+
+    if (m_groupEventsByField)
+    {
+        _groupEventsByField(sorted);
     }
+
+    m_allEvents.swap(sorted);
 }
 
+template<typename pT, uint D>
+void MainMesh<pT, D>::_groupEventsByField(std::vector<Event<pT, D> *> &events) const
+{
+    const uint window = 64;
+
+    for (uint j = 1; j < events.size(); ++j)
+    {
+        Event<pT, D> *event = events[j];
+
+        const MeshField<pT, D> *field = &event->meshField();
+
+        //Look back for the closest event on the same field, as long as the
+        //events in between may run after this one.
+        uint target = j;
+
+        for (uint k = j; k-- > 0 && j - k <= window;)
+        {
+            if (&events[k]->meshField() == field)
+            {
+                target = k + 1;
+                break;
+            }
+
+            if (event->conflictsWith(events[k]) || event->dependsOn(events[k], false))
+            {
+                break;
+            }
+        }
+
+        if (target < j)
+        {
+            std::rotate(events.begin() + target, events.begin() + j, events.begin() + j + 1);
+        }
+    }
+}
 
-template<typename pT>
-void MainMesh<pT>::_initializeNewEvents()
+template<typename pT, uint D>
+void MainMesh<pT, D>::_initializeNewEvents()
 {
-    for (Event<pT>* event : m_currentChunk->m_events) {
+    for (Event<pT, D>* event : m_plan.m_events) {
 
         if (!event->initialized())
         {
-            event->_zeroCycle();
+            event->_zeroCycle(m_currentChunk->m_start);
             event->initialize();
             event->markAsInitialized();
         }
@@ -501,133 +1337,411 @@ void MainMesh<pT>::_initializeNewEvents()
 }
 
 
-template<typename pT>
-void MainMesh<pT>::_setupChunks()
+template<typename pT, uint D>
+void MainMesh<pT, D>::_setupChunks()
 {
+    m_allLoopChunks.clear();
+    m_chunkEvents.clear();
+
+    const uint nEvents = m_allEvents.size();
+
+    //The active set only changes at onsets and one past offsets.
+    std::vector<uint> boundaries;
+    boundaries.reserve(2*nEvents);
 
-    uvec onsetTimes(m_allEvents.size());
-    uvec offsetTimes(m_allEvents.size());
+    std::vector<uint> byOnset(nEvents);
+    std::vector<uint> byOffset(nEvents);
 
-    uint k = 0;
-    for (Event<pT>* event : m_allEvents)
+    for (uint i = 0; i < nEvents; ++i)
     {
-        onsetTimes(k) = event->onsetTime();
-        offsetTimes(k) = event->offsetTime();
-        k++;
+        boundaries.push_back(m_allEvents[i]->onsetTime());
+        boundaries.push_back(m_allEvents[i]->offsetTime() + 1);
+
+        byOnset[i] = i;
+        byOffset[i] = i;
     }
 
-    onsetTimes = unique(onsetTimes);
-    offsetTimes = unique(offsetTimes);
+    std::sort(boundaries.begin(), boundaries.end());
+    boundaries.erase(std::unique(boundaries.begin(), boundaries.end()), boundaries.end());
 
+    std::sort(byOnset.begin(), byOnset.end(), [this] (const uint i, const uint j)
+    {
+        return m_allEvents[i]->onsetTime() < m_allEvents[j]->onsetTime();
+    });
 
+    std::sort(byOffset.begin(), byOffset.end(), [this] (const uint i, const uint j)
+    {
+        return m_allEvents[i]->offsetTime() < m_allEvents[j]->offsetTime();
+    });
 
-    uint start = onsetTimes(0);
-    uint end;
+    //Indices into the priority sorted m_allEvents, so iteration follows priority.
+    std::set<uint> active;
 
-    uint jStart = 0;
-    uint offsetTime;
+    uint nextOnset = 0;
+    uint nextOffset = 0;
 
-    bool debug = false;
+    m_allLoopChunks.reserve(boundaries.size());
 
-    if (debug)
+    //The last boundary is one past the final offset and starts no chunk.
+    for (uint k = 0; k + 1 < boundaries.size(); ++k)
     {
-        cout << onsetTimes << endl;
-        cout << offsetTimes << endl;
+        const uint start = boundaries[k];
+
+        while (nextOnset < nEvents && m_allEvents[byOnset[nextOnset]]->onsetTime() == start)
+        {
+            active.insert(byOnset[nextOnset++]);
+        }
+
+        while (nextOffset < nEvents && m_allEvents[byOffset[nextOffset]]->offsetTime() < start)
+        {
+            active.erase(byOffset[nextOffset++]);
+        }
+
+        m_allLoopChunks.push_back(LoopChunk(start, boundaries[k + 1] - 1, m_chunkEvents.size()));
+
+        for (const uint i : active)
+        {
+            m_chunkEvents.push_back(m_allEvents[i]);
+        }
+
+        m_allLoopChunks.back().m_nEvents = active.size();
     }
 
-    for (uint i = 0; i < onsetTimes.n_elem; ++i) {
 
-        if (i != onsetTimes.n_elem - 1)
+#ifndef NDEBUG
+    dumpLoopChunkInfo();
+#endif
+
+}
+
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_compilePlan()
+{
+    ExecutionPlan &plan = m_plan;
+
+    plan.m_events.assign(m_chunkEvents.begin() + m_currentChunk->m_firstEvent,
+                         m_chunkEvents.begin() + m_currentChunk->m_firstEvent + m_currentChunk->m_nEvents);
+
+    plan.m_everyCycleEvents.clear();
+    plan.m_everyCycleIndices.clear();
+    plan.m_periodicIndices.clear();
+
+    plan.m_due.assign(plan.m_events.size(), 0);
+
+    for (uint i = 0; i < plan.m_events.size(); ++i)
+    {
+        Event<pT, D> *event = plan.m_events[i];
+
+        if (event->period() == 1)
         {
-            end = onsetTimes(i+1) - 1;
+            plan.m_everyCycleEvents.push_back(event);
+            plan.m_everyCycleIndices.push_back(i);
+            plan.m_due[i] = 1;
         }
 
         else
         {
-            end = offsetTimes(offsetTimes.n_elem - 1) + 1;
+            plan.m_periodicIndices.push_back(i);
+        }
+    }
+
+    plan.m_resetEvents.clear();
+
+    for (Event<pT, D> *event : plan.m_events)
+    {
+        if (!event->resetFree())
+        {
+            plan.m_resetEvents.push_back(event);
         }
+    }
 
-        if (debug) cout << "start at " << start << endl;
-        if (debug) cout << "end " << end << endl;
+    if (m_instrumentation.enabled())
+    {
+        for (Event<pT, D> *event : plan.m_events)
+        {
+            m_instrumentation.registerEvent(event);
+        }
+    }
 
-        for (uint j = jStart; j < offsetTimes.n_elem; ++j) {
+    if (m_reporter != nullptr)
+    {
+        for (const Event<pT, D> *event : plan.m_events)
+        {
+            _registerReportSource(event);
+        }
+    }
 
-            offsetTime = offsetTimes(j);
+    if (m_eventPool != nullptr)
+    {
+        plan.m_graph.build(plan.m_events);
+        plan.m_graph.setInstrumentation(m_instrumentation.enabled() ? &m_instrumentation : nullptr);
+    }
+}
 
-            if (debug) cout << "testing offsettime " << offsetTime << endl;
+template<typename pT, uint D>
+void MainMesh<pT, D>::_scheduleChunk(const uint start)
+{
+    const uint maxSlots = 1024;
 
-            if (offsetTime <= end)
-            {
-                if (debug) cout << "adding interval " << start << " - " << offsetTime << endl;
-                m_allLoopChunks.push_back(new LoopChunk(start, offsetTime));
-                start = offsetTime + 1;
-                if (debug) cout << "next interval starting at " << start << endl;
+    uint maxPeriod = 1;
 
-                jStart = j+1;
+    for (const uint i : m_plan.m_periodicIndices)
+    {
+        maxPeriod = std::max(maxPeriod, m_plan.m_events[i]->period());
+    }
 
-            }
+    m_timingWheel.reset(std::min(maxPeriod, maxSlots));
 
-            else
-            {
-                break;
-            }
+    for (const uint i : m_plan.m_periodicIndices)
+    {
+        const Event<pT, D> *event = m_plan.m_events[i];
+
+        const uint period = event->period();
+
+        m_timingWheel.schedule(start + (event->phase() + period - start%period)%period, i);
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_startRuntimeEvents()
+{
+    while (!m_pendingEvents.empty() && m_pendingEvents.front().m_onset <= *m_loopCycle)
+    {
+        Event<pT, D> *event = m_pendingEvents.front().m_event;
+
+        std::pop_heap(m_pendingEvents.begin(), m_pendingEvents.end(), std::greater<PendingEvent>());
+        m_pendingEvents.pop_back();
+
+        event->_zeroCycle(*m_loopCycle);
+        event->initialize();
+        event->markAsInitialized();
+
+        if (m_instrumentation.enabled())
+        {
+            m_instrumentation.registerEvent(event);
         }
 
-        if (start <= end && (i != onsetTimes.n_elem - 1))
+        if (m_reporter != nullptr)
         {
-            if (debug) cout << "adding remaining interval " << start << " - " << end << endl;
-            m_allLoopChunks.push_back(new LoopChunk(start, end));
-            start = end + 1;
+            _registerReportSource(event);
         }
-        if (debug) cout << "------------------------\n";
 
+        const auto position = std::upper_bound(m_runtimeEvents.begin(), m_runtimeEvents.end(), event,
+                                               [] (const Event<pT, D> *e1, const Event<pT, D> *e2) {return e1->priority() < e2->priority();});
+
+        m_runtimeEvents.insert(position, event);
+
+        m_runtimeExpiry = std::min(m_runtimeExpiry, event->offsetTime());
     }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_expireRuntimeEvents()
+{
+    const uint cycle = *m_loopCycle;
 
+    m_runtimeEvents.erase(std::remove_if(m_runtimeEvents.begin(),
+                                         m_runtimeEvents.end(),
+                                         [cycle] (const Event<pT, D> *event) {return event->offsetTime() < cycle;}),
+                          m_runtimeEvents.end());
 
+    m_runtimeExpiry = IGNIS_UNSET_UINT;
 
-    for (Event<pT>* event : m_allEvents) {
-        for (LoopChunk* loopChunk : m_allLoopChunks) {
-            if (event->onsetTime() <= loopChunk->m_start && event->offsetTime() >= loopChunk->m_end) {
-                loopChunk->m_events.push_back(event);
-            }
+    for (const Event<pT, D> *event : m_runtimeEvents)
+    {
+        m_runtimeExpiry = std::min(m_runtimeExpiry, event->offsetTime());
+    }
+}
+
+template<typename pT, uint D>
+void MainMesh<pT, D>::_executeEvents()
+{
+    ExecutionPlan &plan = m_plan;
+
+    if (*m_loopCycle > m_runtimeExpiry)
+    {
+        _expireRuntimeEvents();
+    }
+
+    if (!m_pendingEvents.empty() && m_pendingEvents.front().m_onset <= *m_loopCycle)
+    {
+        _startRuntimeEvents();
+    }
+
+    m_nextCycle = *m_loopCycle + 1;
+    m_executing = true;
+
+    if (m_instrumentation.enabled())
+    {
+        m_instrumentation.beginCycle(*m_loopCycle);
+    }
+
+    m_dueEvents.clear();
+    m_timingWheel.advance(*m_loopCycle, m_dueEvents);
+
+    if (!m_dueEvents.empty())
+    {
+        std::sort(m_dueEvents.begin(), m_dueEvents.end());
+
+        for (const uint i : m_dueEvents)
+        {
+            plan.m_due[i] = 1;
+            m_timingWheel.schedule(*m_loopCycle + plan.m_events[i]->period(), i);
         }
     }
 
+    //Runtime events are not part of the graph, so cycles with any run serially.
+    if (m_eventPool != nullptr && plan.m_graph.parallel() && m_runtimeEvents.empty())
+    {
+        m_executingInParallel = true;
+        plan.m_graph.execute(*m_eventPool, plan.m_due.data());
+        m_executingInParallel = false;
+    }
 
-#ifndef NDEBUG
-    dumpLoopChunkInfo();
-#endif
+    else
+    {
+        const std::vector<Event<pT, D> *> *cycleEvents = &plan.m_everyCycleEvents;
 
-}
+        if (!m_dueEvents.empty())
+        {
+            //Both lists are in priority order.
+            m_cycleEvents.clear();
 
+            uint k = 0;
 
-template<typename pT>
-void MainMesh<pT>::_executeEvents()
-{
+            for (const uint i : plan.m_everyCycleIndices)
+            {
+                while (k < m_dueEvents.size() && m_dueEvents[k] < i)
+                {
+                    m_cycleEvents.push_back(plan.m_events[m_dueEvents[k++]]);
+                }
+
+                m_cycleEvents.push_back(plan.m_events[i]);
+            }
+
+            while (k < m_dueEvents.size())
+            {
+                m_cycleEvents.push_back(plan.m_events[m_dueEvents[k++]]);
+            }
+
+            cycleEvents = &m_cycleEvents;
+        }
+
+        if (m_runtimeEvents.empty())
+        {
+            for (Event<pT, D> * event : *cycleEvents)
+            {
+                _execute(event);
+            }
+        }
+
+        else
+        {
+            uint k = 0;
+
+            for (Event<pT, D> * event : *cycleEvents)
+            {
+                while (k < m_runtimeEvents.size() && m_runtimeEvents[k]->priority() < event->priority())
+                {
+                    _execute(m_runtimeEvents[k++]);
+                }
+
+                _execute(event);
+            }
+
+            while (k < m_runtimeEvents.size())
+            {
+                _execute(m_runtimeEvents[k++]);
+            }
+        }
+    }
+
+    for (const uint i : m_dueEvents)
+    {
+        plan.m_due[i] = 0;
+    }
 
-    for (Event<pT> * event : m_currentChunk->m_events)
+    for (Event<pT, D> * event : m_plan.m_resetEvents)
     {
-        event->execute();
+        _reset(event);
     }
 
-    for (Event<pT> * event : m_currentChunk->m_events)
+    for (Event<pT, D> * event : m_runtimeEvents)
     {
-        event->reset();
+        if (!event->resetFree())
+        {
+            _reset(event);
+        }
     }
 
-    for (Event<pT> * event : m_currentChunk->m_events)
+    m_executing = false;
+
+    if (!m_retiredEvents.empty())
     {
-        event->_iterateCycle();
+        std::vector<Event<pT, D> *> retiredEvents;
+        retiredEvents.swap(m_retiredEvents);
+
+        for (Event<pT, D> *event : retiredEvents)
+        {
+            retireEvent(event);
+        }
     }
 
 }
 
-template<typename pT>
-void MainMesh<pT>::dumpEvents() const
+template<typename pT, uint D>
+void MainMesh<pT, D>::dumpEvents() const
 {
+    if (m_reporter != nullptr)
+    {
+        bool endBlock = false;
+
+        for (const std::vector<Event<pT, D> *> *events : {&m_plan.m_events, &m_runtimeEvents})
+        {
+            for (Event<pT, D>* event : *events)
+            {
+                if (!event->hasOutput())
+                {
+                    continue;
+                }
+
+                const uint source = m_reportSources.find(event)->second;
+
+                if (event->valueSetThisCycle())
+                {
+                    m_reporter->report(source, event->value());
+                    event->valueSetThisCycle(false);
+                }
+
+                else
+                {
+                    m_reporter->report(source);
+                }
+
+                endBlock = true;
+            }
+        }
+
+        if (endBlock)
+        {
+            m_reporter->endBlock();
+        }
+
+        return;
+    }
 
     bool endline = false;
-    for (Event<pT>* event : m_currentChunk->m_events)
+    for (Event<pT, D>* event : m_plan.m_events)
+    {
+        if (event->hasOutput())
+        {
+            cout << event->dumpString() << endl;
+            endline = true;
+        }
+    }
+
+    for (Event<pT, D>* event : m_runtimeEvents)
     {
         if (event->hasOutput())
         {
@@ -643,5 +1757,5 @@ void MainMesh<pT>::dumpEvents() const
 
 }
 
-template<typename pT>
-PositionHandler<pT> *MainMesh<pT>::m_currentParticles = nullptr;
+template<typename pT, uint D>
+PositionHandler<pT, D> *MainMesh<pT, D>::m_currentParticles = nullptr;
@@ -3,16 +3,30 @@
 
 #include "../meshfield.h"
 
+#include "../../positionhandler.h"
+
+#include "../../Event/eventgraph.h"
+
+#include "../../Event/timingwheel.h"
+
+#include "../../Profiling/instrumentation.h"
+
+#include "../../IO/ignwriter.h"
+
+#include "../../IO/ignformat.h"
+
+#include "../../IO/asyncreporter.h"
+
 #include <fstream>
+#include <mutex>
+#include <unordered_map>
+#include <stdint.h>
 
 namespace ignis
 {
 
-template<typename pT>
-class _particleHandler;
-
-template<typename pT>
-class MainMesh : public MeshField<pT>
+template<typename pT, uint D>
+class MainMesh : public MeshField<pT, D>
 {
 
 public:
@@ -34,18 +48,18 @@ public:
         return true;
     }
 
-    static void setCurrentParticles(PositionHandler<pT> &particles)
+    static void setCurrentParticles(PositionHandler<pT, D> &particles)
     {
         m_currentParticles = &particles;
     }
 
-    static void setCurrentParticles(PositionHandler<pT> *particles)
+    static void setCurrentParticles(PositionHandler<pT, D> *particles)
     {
         m_currentParticles = particles;
     }
 
 
-    static PositionHandler<pT> * currentParticles()
+    static PositionHandler<pT, D> * currentParticles()
     {
         return m_currentParticles;
     }
@@ -133,6 +147,113 @@ public:
 
     }
 
+    //! Resolve subfield containments through a uniform cell grid instead of
+    //! walking the subfield tree for every particle.
+    void enableSpatialIndex(const bool state = true, const uint cellsPerDimension = 16);
+
+    //! Only re-bin particles which left their deepest subfield (expanded by skin).
+    //! Atom lists are then updated in place and are no longer sorted.
+    //! Takes precedence over the spatial index. Fields with overlapping sibling
+    //! subfields are still updated by the full pass.
+    void enableIncrementalContainment(const bool state = true, const double skin = 0);
+
+    //! Bin particles on several threads (requires CONFIG += omp). Atom lists are
+    //! merged in thread order and stay sorted. Not used for incremental containment.
+    void setContainmentThreads(const uint nThreads);
+
+    const uint &containmentThreads() const
+    {
+        return m_containmentThreads;
+    }
+
+    //! On every containment update, nearFace is set to the sorted indices of the
+    //! particles outside field shrunk by margin, i.e. close to a face or outside.
+    //! Until the first update every particle is listed. nearFace is owned by the
+    //! caller and must be untracked before it is destroyed.
+    void _trackFaces(const MeshField<pT, D> *field, const pT margin, std::vector<uint> *nearFace);
+
+    void _untrackFaces(const std::vector<uint> *nearFace);
+
+    //! Events are ordered after their dependencies and otherwise by priority.
+    //! With grouping, an event is also moved up behind the closest preceding
+    //! event on the same mesh field, so field data stays in cache, if the
+    //! events it passes have declared accesses which do not conflict with its own.
+    void enableFieldGrouping(const bool state = true)
+    {
+        m_groupEventsByField = state;
+    }
+
+    //! Master seed of the events' random streams (Event::random). An event's
+    //! stream is its position among the mesh's events in execution order, with
+    //! runtime events numbered after them in insertion order (see insertEvent).
+    //! The same seed and event setup give the same numbers, whatever the thread counts.
+    void setSeed(const uint64_t seed)
+    {
+        BADAssBool(m_finalized, "The seed cannot be changed while the loop runs.");
+
+        m_seed = seed;
+    }
+
+    const uint64_t &seed() const
+    {
+        return m_seed;
+    }
+
+    //! Run events of a cycle concurrently on nThreads threads where their
+    //! dependencies and declared accesses allow it. 1 runs them serially.
+    void setEventThreads(const uint nThreads);
+
+    uint eventThreads() const
+    {
+        return m_eventPool == nullptr ? 1 : m_eventPool->nThreads();
+    }
+
+    //! Event output is handed to a formatter thread through a queue of
+    //! capacity records instead of being formatted and written in the loop.
+    void enableAsyncOutput(const bool state = true, const uint capacity = 1 << 14, std::ostream &out = std::cout);
+
+    //! Stored event values are written through a ring of blockSize values
+    //! which a background thread (async) drains to disk. Partial blocks are
+    //! written at the latest flushInterval seconds after they were started.
+    void setEventStorageBuffering(const uint blockSize,
+                                  const uint nBlocks = 8,
+                                  const bool async = true,
+                                  const double flushInterval = 5.0)
+    {
+        m_eventStorageFile.setBuffering(blockSize, nBlocks, async, flushInterval);
+    }
+
+    //! Stored event values are compressed column wise in blocks of blockRows
+    //! stored cycles. Rows are then only readable through IgnReader. 0 disables.
+    void setEventStorageCompression(const uint blockRows)
+    {
+        m_eventStorageFile.setCompression(blockRows);
+    }
+
+    //! Time every execute() and reset() call and the containment updates. A
+    //! table is printed on finalize(), and the timings are written to
+    //! outputPath/name.json and .csv.
+    void enableProfiling(const bool state = true, const std::string &name = "ignisProfile");
+
+    bool profiling() const
+    {
+        return m_instrumentation.m_profiler != nullptr;
+    }
+
+    //! Record a Chrome trace (chrome://tracing, Perfetto) of every
+    //! sampleInterval'th cycle: events, containment updates, chunks and
+    //! event storage writes. At most maxRecords records are kept per thread.
+    //! Written to outputPath/name.json on finalize().
+    void enableTracing(const bool state = true,
+                       const uint sampleInterval = 1,
+                       const uint maxRecords = 1 << 18,
+                       const std::string &name = "ignisTrace");
+
+    bool tracing() const
+    {
+        return m_instrumentation.m_tracer != nullptr;
+    }
+
     const uint &saveValuesSpacing()
     {
         return m_saveValuesSpacing;
@@ -146,7 +267,9 @@ public:
 
     void _initializeEventStorage(const uint size);
 
-    void _storeEventValues(const uint index);
+    void _storeEventValues();
+
+    void _finalizeEventStorage();
 
     void dumpLoopChunkInfo();
 
@@ -178,20 +301,37 @@ public:
 
         if (m_storeEvents)
         {
-            m_storedEventValues.resize(cycle/saveValuesSpacing(), numberOfStoredEvents());
+            m_storedEventValues.resize(m_nStoredRows, numberOfStoredEvents());
         }
     }
 
     void finalize();
 
-    void removeEventFromChunks(Event<pT> *event);
-
-    MainMesh<pT> *mainMesh()
+    void removeEventFromChunks(Event<pT, D> *event);
+
+    //! Adds an event to field (the main mesh by default) while the loop runs. It is
+    //! active for length cycles (until the end by default), starting onset cycles
+    //! after the next cycle to execute. Chunks are left untouched. Runtime events
+    //! cannot store values. Insertions are numbered (priority and random stream) in
+    //! call order, so they are an error in cycles which run on several event
+    //! threads (setEventThreads), where that order would depend on thread timing.
+    void insertEvent(Event<pT, D> *event,
+                     const uint onset = 0,
+                     const uint length = IGNIS_UNSET_UINT,
+                     MeshField<pT, D> *field = nullptr);
+
+    //! Removes an event while the loop runs. Inside a cycle the removal happens
+    //! once the cycle has finished, so the event must live until then. Each
+    //! removal costs O(E) in the number of events, since the event lists and the
+    //! overlapping chunks are vectors which are searched and compacted.
+    void retireEvent(Event<pT, D> *event);
+
+    MainMesh<pT, D> *mainMesh()
     {
         return this;
     }
 
-    friend class _particleHandler<pT>;
+    friend class _particleHandler<pT, D>;
 
 private:
 
@@ -201,21 +341,29 @@ private:
 
     bool m_chunkStarted;
 
-    static PositionHandler<pT> *m_currentParticles;
+    static PositionHandler<pT, D> *m_currentParticles;
 
     mat m_storedEventValues;
 
     std::vector<std::string> m_storedEventTypes;
 
-    std::ofstream m_eventStorageFile;
+    IgnWriter m_eventStorageFile;
+
+    uint m_nStoredRows;
 
     std::string m_outputPath;
 
-    std::vector<Event<pT> *> m_allEvents;
+    std::vector<Event<pT, D> *> m_allEvents;
 
-    std::vector<Event<pT> *> m_intrinsicEvents;
+    std::vector<Event<pT, D> *> m_intrinsicEvents;
 
-    std::vector<Event<pT> *> m_storageEnabledEvents;
+    std::vector<Event<pT, D> *> m_storageEnabledEvents;
+
+    //! Values and value flags of the loop's events, owned here while the loop
+    //! runs. Storage enabled events come first, in column order, so a stored
+    //! row is the first numberOfStoredEvents() values.
+    double *m_eventValues;
+    bool *m_eventValueFlags;
 
     bool m_handleParticles;
 
@@ -230,33 +378,132 @@ private:
 
     bool m_reportProgress;
 
+    bool m_useSpatialIndex;
+    ContainmentGrid<pT, D> *m_containmentGrid;
+
+    bool m_useIncrementalContainment;
+    ContainmentTracker<pT, D> *m_containmentTracker;
+
+    uint m_containmentThreads;
+    std::vector<MeshField<pT, D> *> m_flatFields;
+    std::vector<uint> m_flatParents;
+    std::vector<std::vector<std::vector<uint> > > m_threadAtoms;
+
+    struct FaceTracker
+    {
+        const MeshField<pT, D> *m_field;
+        pT m_margin;
+        std::vector<uint> *m_nearFace;
+    };
+
+    std::vector<FaceTracker> m_faceTrackers;
+
+    WorkStealingPool *m_eventPool;
+
+    bool m_groupEventsByField;
+
+    uint64_t m_seed;
+    uint64_t m_nextStream;
+
+    AsyncReporter *m_reporter;
+    std::unordered_map<const Event<pT, D> *, uint> m_reportSources;
+
+    Instrumentation<pT, D> m_instrumentation;
+    std::string m_profileName;
+    std::string m_traceName;
+
+    TimingWheel m_timingWheel;
+    std::vector<uint> m_dueEvents;
+
+    struct PendingEvent
+    {
+        uint m_onset;
+        Event<pT, D> *m_event;
+
+        bool operator > (const PendingEvent &other) const
+        {
+            return m_onset > other.m_onset;
+        }
+    };
+
+    uint m_nCycles;
+
+    //! Runtime events: a min-heap on onset, and the started ones in priority order.
+    std::vector<PendingEvent> m_pendingEvents;
+    std::vector<Event<pT, D> *> m_runtimeEvents;
+    uint m_runtimeExpiry;
+
+    std::vector<Event<pT, D> *> m_retiredEvents;
+
+    std::vector<Event<pT, D> *> m_cycleEvents;
+
+    uint m_nextCycle;
+    bool m_executing;
+    bool m_executingInParallel;
+
+    std::mutex m_scheduleMutex;
+
     bool m_stop;
 
     bool m_terminate;
     std::string m_terminateMessage;
     std::string m_terminator;
 
+    //! Cycles [m_start, m_end] during which the set of active events is constant.
+    //! The events are m_chunkEvents[m_firstEvent, m_firstEvent + m_nEvents) in priority order.
     struct LoopChunk
     {
 
         uint m_start;
         uint m_end;
 
-        std::vector<Event<pT> *> m_events;
+        uint m_firstEvent;
+        uint m_nEvents;
+
+        LoopChunk(uint start, uint end, uint firstEvent) :
+            m_start(start),
+            m_end(end),
+            m_firstEvent(firstEvent),
+            m_nEvents(0)
+        {
+
+        }
+
+    };
+
+    //! How the events of the current chunk are executed, compiled when the chunk starts.
+    struct ExecutionPlan
+    {
+
+        std::vector<Event<pT, D> *> m_events;
+
+        //! Events with period 1, as pointers for the plain loop and as indices into m_events for merging.
+        std::vector<Event<pT, D> *> m_everyCycleEvents;
+        std::vector<uint> m_everyCycleIndices;
 
-        LoopChunk(uint i, uint j) : m_start(i), m_end(j) {}
+        std::vector<uint> m_periodicIndices;
+
+        //! Nonzero for events executing this cycle.
+        std::vector<char> m_due;
+
+        //! Events which are not reset free.
+        std::vector<Event<pT, D> *> m_resetEvents;
+
+        EventGraph<pT, D> m_graph;
 
     };
 
 
-    std::vector<LoopChunk *> m_allLoopChunks;
+    std::vector<LoopChunk> m_allLoopChunks;
+
+    std::vector<Event<pT, D> *> m_chunkEvents;
+
+    ExecutionPlan m_plan;
 
     LoopChunk * m_currentChunk;
     uint m_currentChunkIndex;
 
-    void _streamValueToFile(const double value);
-
-    void _sendToTop(Event<pT> &event);
+    void _sendToTop(Event<pT, D> &event);
 
 
     void _addIntrinsicEvents();
@@ -264,16 +511,74 @@ private:
 
     void _sortEvents();
 
+    void _groupEventsByField(std::vector<Event<pT, D> *> &events) const;
+
     void _initializeNewEvents();
 
     void _setupChunks();
 
+    void _compilePlan();
+
+    void _scheduleChunk(const uint start);
+
     void _executeEvents();
 
+    void _startRuntimeEvents();
+
+    void _expireRuntimeEvents();
+
+    void _removeEvent(Event<pT, D> *event);
+
+    void _bindEventValues();
+
+    void _unbindEventValues();
+
+    void _registerReportSource(const Event<pT, D> *event);
+
+    void _execute(Event<pT, D> *event)
+    {
+        if (!m_instrumentation.enabled())
+        {
+            event->execute();
+        }
+
+        else
+        {
+            m_instrumentation.execute(event);
+        }
+    }
+
+    void _reset(Event<pT, D> *event)
+    {
+        if (!m_instrumentation.enabled())
+        {
+            event->reset();
+        }
+
+        else
+        {
+            m_instrumentation.reset(event);
+        }
+    }
+
 
     void _updateContainments();
 
-    void _addIntrinsicEvent(Event<pT> *event)
+    void _updateContainmentsFlattened();
+
+    void _updateFaceTrackers();
+
+    void _resetNearFaces(std::vector<uint> &nearFace) const;
+
+    void _binParticle(const uint i, std::vector<std::vector<uint> *> &targets) const;
+
+    void _binBlock(const PositionSpan<pT, D> &positions,
+                   const uint first,
+                   const uint n,
+                   std::vector<uint64_t> &masks,
+                   std::vector<std::vector<uint> *> &targets) const;
+
+    void _addIntrinsicEvent(Event<pT, D> *event)
     {
         this->addEvent(event);
         m_intrinsicEvents.push_back(event);
@@ -0,0 +1,277 @@
+#pragma once
+
+#include "../positionhandler.h"
+
+#include <vector>
+#include <algorithm>
+#include <stdint.h>
+
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+namespace ignis
+{
+
+/*
+ * Batch box containment kernels.
+ *
+ * boxMask() tests up to IGNIS_BOX_BLOCK consecutive particles against the
+ * box [low, high] (inclusive, like MeshField::isWithinThis) and returns one
+ * bit per particle. Vectorized versions are compiled in for float and double
+ * when building with AVX2 or AVX-512 enabled (e.g. CONFIG += native);
+ * everything else uses the scalar loop.
+ */
+
+const uint IGNIS_BOX_BLOCK = 64;
+
+template<typename pT, uint D>
+uint64_t boxMaskScalar(const PositionSpan<pT, D> &positions,
+                       const pT *low,
+                       const pT *high,
+                       const uint first,
+                       const uint n)
+{
+    uint64_t result = 0;
+
+    for (uint k = 0; k < n; ++k)
+    {
+        bool inside = true;
+
+        for (uint d = 0; d < D; ++d)
+        {
+            const pT &x = positions(first + k, d);
+            inside = inside && (x >= low[d]) && (x <= high[d]);
+        }
+
+        result |= (uint64_t)inside << k;
+    }
+
+    return result;
+}
+
+template<typename pT, uint D>
+struct BoxKernel
+{
+    static uint64_t mask(const PositionSpan<pT, D> &positions,
+                         const pT *low,
+                         const pT *high,
+                         const uint first,
+                         const uint n)
+    {
+        return boxMaskScalar(positions, low, high, first, n);
+    }
+};
+
+#if defined(__AVX512F__)
+
+template<uint D>
+struct BoxKernel<double, D>
+{
+    static uint64_t mask(const PositionSpan<double, D> &positions,
+                         const double *low,
+                         const double *high,
+                         const uint first,
+                         const uint n)
+    {
+        const uint nVector = n - n%8;
+
+        const int s = positions.particleStride;
+        const __m256i offsets = _mm256_set_epi32(7*s, 6*s, 5*s, 4*s, 3*s, 2*s, s, 0);
+
+        uint64_t result = 0;
+
+        for (uint k = 0; k < nVector; k += 8)
+        {
+            __mmask8 inside = 0xff;
+
+            for (uint d = 0; d < D; ++d)
+            {
+                const double *x = &positions(first + k, d);
+
+                const __m512d values = s == 1 ? _mm512_loadu_pd(x) : _mm512_i32gather_pd(offsets, x, 8);
+
+                inside &= _mm512_cmp_pd_mask(values, _mm512_set1_pd(low[d]), _CMP_GE_OQ);
+                inside &= _mm512_cmp_pd_mask(values, _mm512_set1_pd(high[d]), _CMP_LE_OQ);
+            }
+
+            result |= (uint64_t)inside << k;
+        }
+
+        if (nVector == n)
+        {
+            return result;
+        }
+
+        return result | (boxMaskScalar(positions, low, high, first + nVector, n - nVector) << nVector);
+    }
+};
+
+template<uint D>
+struct BoxKernel<float, D>
+{
+    static uint64_t mask(const PositionSpan<float, D> &positions,
+                         const float *low,
+                         const float *high,
+                         const uint first,
+                         const uint n)
+    {
+        const uint nVector = n - n%16;
+
+        const __m512i offsets = _mm512_mullo_epi32(_mm512_set_epi32(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0),
+                                                   _mm512_set1_epi32(positions.particleStride));
+
+        uint64_t result = 0;
+
+        for (uint k = 0; k < nVector; k += 16)
+        {
+            __mmask16 inside = 0xffff;
+
+            for (uint d = 0; d < D; ++d)
+            {
+                const float *x = &positions(first + k, d);
+
+                const __m512 values = positions.particleStride == 1 ? _mm512_loadu_ps(x) : _mm512_i32gather_ps(offsets, x, 4);
+
+                inside &= _mm512_cmp_ps_mask(values, _mm512_set1_ps(low[d]), _CMP_GE_OQ);
+                inside &= _mm512_cmp_ps_mask(values, _mm512_set1_ps(high[d]), _CMP_LE_OQ);
+            }
+
+            result |= (uint64_t)inside << k;
+        }
+
+        if (nVector == n)
+        {
+            return result;
+        }
+
+        return result | (boxMaskScalar(positions, low, high, first + nVector, n - nVector) << nVector);
+    }
+};
+
+#elif defined(__AVX2__)
+
+template<uint D>
+struct BoxKernel<double, D>
+{
+    static uint64_t mask(const PositionSpan<double, D> &positions,
+                         const double *low,
+                         const double *high,
+                         const uint first,
+                         const uint n)
+    {
+        const uint nVector = n - n%4;
+
+        const int s = positions.particleStride;
+        const __m128i offsets = _mm_set_epi32(3*s, 2*s, s, 0);
+
+        uint64_t result = 0;
+
+        for (uint k = 0; k < nVector; k += 4)
+        {
+            __m256d inside = _mm256_castsi256_pd(_mm256_set1_epi64x(-1));
+
+            for (uint d = 0; d < D; ++d)
+            {
+                const double *x = &positions(first + k, d);
+
+                const __m256d values = s == 1 ? _mm256_loadu_pd(x) : _mm256_i32gather_pd(x, offsets, 8);
+
+                inside = _mm256_and_pd(inside, _mm256_cmp_pd(values, _mm256_set1_pd(low[d]), _CMP_GE_OQ));
+                inside = _mm256_and_pd(inside, _mm256_cmp_pd(values, _mm256_set1_pd(high[d]), _CMP_LE_OQ));
+            }
+
+            result |= (uint64_t)_mm256_movemask_pd(inside) << k;
+        }
+
+        if (nVector == n)
+        {
+            return result;
+        }
+
+        return result | (boxMaskScalar(positions, low, high, first + nVector, n - nVector) << nVector);
+    }
+};
+
+template<uint D>
+struct BoxKernel<float, D>
+{
+    static uint64_t mask(const PositionSpan<float, D> &positions,
+                         const float *low,
+                         const float *high,
+                         const uint first,
+                         const uint n)
+    {
+        const uint nVector = n - n%8;
+
+        const int s = positions.particleStride;
+        const __m256i offsets = _mm256_set_epi32(7*s, 6*s, 5*s, 4*s, 3*s, 2*s, s, 0);
+
+        uint64_t result = 0;
+
+        for (uint k = 0; k < nVector; k += 8)
+        {
+            __m256 inside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+            for (uint d = 0; d < D; ++d)
+            {
+                const float *x = &positions(first + k, d);
+
+                const __m256 values = s == 1 ? _mm256_loadu_ps(x) : _mm256_i32gather_ps(x, offsets, 4);
+
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(values, _mm256_set1_ps(low[d]), _CMP_GE_OQ));
+                inside = _mm256_and_ps(inside, _mm256_cmp_ps(values, _mm256_set1_ps(high[d]), _CMP_LE_OQ));
+            }
+
+            result |= (uint64_t)_mm256_movemask_ps(inside) << k;
+        }
+
+        if (nVector == n)
+        {
+            return result;
+        }
+
+        return result | (boxMaskScalar(positions, low, high, first + nVector, n - nVector) << nVector);
+    }
+};
+
+#endif
+
+//! Bit k is set if particle first + k is inside [low, high]. n <= IGNIS_BOX_BLOCK.
+template<typename pT, uint D>
+uint64_t boxMask(const PositionSpan<pT, D> &positions,
+                 const pT *low,
+                 const pT *high,
+                 const uint first,
+                 const uint n)
+{
+    return BoxKernel<pT, D>::mask(positions, low, high, first, n);
+}
+
+inline void appendMaskedIndices(uint64_t mask, const uint first, std::vector<uint> &indices)
+{
+    while (mask != 0)
+    {
+        indices.push_back(first + __builtin_ctzll(mask));
+        mask &= mask - 1;
+    }
+}
+
+//! Appends the (sorted) indices in [first, last) of particles inside [low, high].
+template<typename pT, uint D>
+void boxContainment(const PositionSpan<pT, D> &positions,
+                    const pT *low,
+                    const pT *high,
+                    const uint first,
+                    const uint last,
+                    std::vector<uint> &indices)
+{
+    for (uint block = first; block < last; block += IGNIS_BOX_BLOCK)
+    {
+        const uint n = std::min(IGNIS_BOX_BLOCK, last - block);
+
+        appendMaskedIndices(boxMask(positions, low, high, block, n), block, indices);
+    }
+}
+
+}
@@ -2,47 +2,66 @@
 
 #include "MainMesh/mainmesh.h"
 
+#include "../positionhandler.h"
+
+#include "boxkernel.h"
+
 using namespace ignis;
 
-template<typename pT>
-MeshField<pT>::MeshField(const std::string description) :
+template<typename pT, uint D>
+MeshField<pT, D>::MeshField(const std::string description) :
     volume(0),
     m_description(description),
-    m_particles(MainMesh<pT>::currentParticles())
+    m_particles(MainMesh<pT, D>::currentParticles())
 {
     topmat *_top = new topmat(fill::zeros);
     setTopology(*_top);
 }
 
-template<typename pT>
-MeshField<pT>::MeshField(const topmat &topology, const std::string description) :
+template<typename pT, uint D>
+MeshField<pT, D>::MeshField(const topmat &topology, const std::string description) :
     volume(0),
     m_description(description),
-    m_particles(MainMesh<pT>::currentParticles())
+    m_particles(MainMesh<pT, D>::currentParticles())
 {
     setTopology(topology, false);
 }
 
-template<typename pT>
-MeshField<pT>::MeshField(const std::initializer_list<pT> topology, const std::string description) :
+template<typename pT, uint D>
+MeshField<pT, D>::MeshField(const std::initializer_list<pT> topology, const std::string description) :
     volume(0),
     m_description(description),
-    m_particles(MainMesh<pT>::currentParticles())
+    m_particles(MainMesh<pT, D>::currentParticles())
 {
     setTopology(topology);
 }
 
-template<typename pT>
-MeshField<pT>::~MeshField()
+template<typename pT, uint D>
+MeshField<pT, D>::~MeshField()
 {
 
 }
 
 
-template<typename pT>
-bool MeshField<pT>::isWithinThis(uint i) {
+template<typename pT, uint D>
+bool MeshField<pT, D>::isWithinThis(uint i) {
+
+    const PositionSpan<pT, D> positions = m_particles->span();
+
+    if (positions.valid())
+    {
+        for (uint j = 0; j < D; ++j)
+        {
+            if (positions(i, j) < topology(j, 0) || positions(i, j) > topology(j, 1))
+            {
+                return false;
+            }
+        }
+
+        return true;
+    }
 
-    for (uint j = 0; j < IGNIS_DIM; ++j) {
+    for (uint j = 0; j < D; ++j) {
         if (particles(i, j) < topology(j, 0)){
             return false;
         } else if (particles(i, j) > topology(j, 1)) {
@@ -54,10 +73,34 @@ bool MeshField<pT>::isWithinThis(uint i) {
 
 }
 
+template<typename pT, uint D>
+void MeshField<pT, D>::findWithinThis(std::vector<uint> &indices, const uint first, uint last)
+{
+    if (last == IGNIS_UNSET_UINT)
+    {
+        last = m_particles->count();
+    }
+
+    const PositionSpan<pT, D> positions = m_particles->span();
+
+    if (positions.valid() && !hasCustomGeometry())
+    {
+        boxContainment(positions, topology.memptr(), topology.memptr() + D, first, last, indices);
+        return;
+    }
+
+    for (uint i = first; i < last; ++i)
+    {
+        if (isWithinThis(i))
+        {
+            indices.push_back(i);
+        }
+    }
+}
 
 
-template<typename pT>
-void MeshField<pT>::removeEvent(uint i)
+template<typename pT, uint D>
+void MeshField<pT, D>::removeEvent(uint i)
 {
     mainMesh()->removeEventFromChunks(m_events.at(i));
 
@@ -69,16 +112,16 @@ void MeshField<pT>::removeEvent(uint i)
     }       
 }
 
-template<typename pT>
-void MeshField<pT>::removeEvent(const Event<pT> *event)
+template<typename pT, uint D>
+void MeshField<pT, D>::removeEvent(const Event<pT, D> *event)
 {
     removeEvent(event->meshAddress());
 }
 
-template<typename pT>
-void MeshField<pT>::resetSubFields()
+template<typename pT, uint D>
+void MeshField<pT, D>::resetSubFields()
 {
-    for (MeshField<pT> *subField : m_subFields)
+    for (MeshField<pT, D> *subField : m_subFields)
     {
         subField->resetSubFields();
     }
@@ -86,16 +129,16 @@ void MeshField<pT>::resetSubFields()
     resetContents();
 }
 
-template<typename pT>
-void MeshField<pT>::_prepareEvents(const uint nCycles, const uint *loopCyclePtr)
+template<typename pT, uint D>
+void MeshField<pT, D>::_prepareEvents(const uint nCycles, const uint *loopCyclePtr)
 {
 
-    for (Event<pT> *event : m_events)
+    for (Event<pT, D> *event : m_events)
     {
         _prepareEvent(event, nCycles, loopCyclePtr);
     }
 
-    for (MeshField<pT>* subfield : m_subFields)
+    for (MeshField<pT, D>* subfield : m_subFields)
     {
         subfield->_prepareEvents(nCycles, loopCyclePtr);
     }
@@ -103,8 +146,8 @@ void MeshField<pT>::_prepareEvents(const uint nCycles, const uint *loopCyclePtr)
 }
 
 
-template<typename pT>
-bool MeshField<pT>::append(uint i)
+template<typename pT, uint D>
+bool MeshField<pT, D>::append(uint i)
 {
 
     if (isWithinThis(i)){
@@ -116,32 +159,32 @@ bool MeshField<pT>::append(uint i)
 
 }
 
-template<typename pT>
-void MeshField<pT>::_sendToTop(Event<pT> &event)
+template<typename pT, uint D>
+void MeshField<pT, D>::_sendToTop(Event<pT, D> &event)
 {
     m_parent->_sendToTop(event);
 }
 
-template<typename pT>
-void MeshField<pT>::terminateLoop(std::string terminateMessage, std::string terminator)
+template<typename pT, uint D>
+void MeshField<pT, D>::terminateLoop(std::string terminateMessage, std::string terminator)
 {
     m_parent->terminateLoop(terminateMessage, terminator);
 }
 
-template<typename pT>
-void MeshField<pT>::stopLoop()
+template<typename pT, uint D>
+void MeshField<pT, D>::stopLoop()
 {
     m_parent->stopLoop();
 }
 
-template<typename pT>
-bool MeshField<pT>::checkSubFields(uint i)
+template<typename pT, uint D>
+bool MeshField<pT, D>::checkSubFields(uint i)
 {
 
     bool matchInSubField;
     bool matchedInSubLevel = false;
 
-    for (MeshField<pT>* subField : m_subFields)
+    for (MeshField<pT, D>* subField : m_subFields)
     {
 
         matchInSubField = subField->checkSubFields(i);
@@ -163,9 +206,25 @@ bool MeshField<pT>::checkSubFields(uint i)
 }
 
 
+template<typename pT, uint D>
+void MeshField<pT, D>::_flattenSubFields(std::vector<MeshField<pT, D>*> &fields,
+                                      std::vector<uint> &parents,
+                                      const uint parent) const
+{
+    for (MeshField<pT, D> *subField : m_subFields)
+    {
+        const uint address = fields.size();
+
+        fields.push_back(subField);
+        parents.push_back(parent);
+
+        subField->_flattenSubFields(fields, parents, address);
+    }
+}
+
 
-template<typename pT>
-bool MeshField<pT>::notCompatible(MeshField<pT> &subField)
+template<typename pT, uint D>
+bool MeshField<pT, D>::notCompatible(MeshField<pT, D> &subField)
 {
 
     if (&subField == this) return true;
@@ -173,48 +232,27 @@ bool MeshField<pT>::notCompatible(MeshField<pT> &subField)
     const topmat & sft = subField.topology;
     const topmat & tft = this->topology;
 
-#if IGNIS_DIM == 2
-    bool outsideMesh =  (sft(0, 0) < tft(0, 0)) ||
-            (sft(0, 1) > tft(0, 1)) ||
-            (sft(1, 0) < tft(1, 0)) ||
-            (sft(1, 1) > tft(1, 1));
-
-    bool equalMesh   =  (sft(0, 0) == tft(0, 0)) &&
-            (sft(0, 1) == tft(0, 1)) &&
-            (sft(1, 0) == tft(1, 0)) &&
-            (sft(1, 1) == tft(1, 1));
-    bool inverted    =  (sft(0, 0) >= sft(0, 1)) ||
-            (sft(1, 0) >= sft(1, 1));
-#elif IGNIS_DIM == 3
-    bool outsideMesh =  (sft(0, 0) < tft(0, 0)) ||
-            (sft(0, 1) > tft(0, 1)) ||
-            (sft(1, 0) < tft(1, 0)) ||
-            (sft(1, 1) > tft(1, 1)) ||
-            (sft(2, 0) < tft(2, 0)) ||
-            (sft(2, 1) > tft(2, 1));
-
-    bool equalMesh   =  (sft(0, 0) == tft(0, 0)) &&
-            (sft(1, 0) == tft(1, 0)) &&
-            (sft(0, 1) == tft(0, 1)) &&
-            (sft(1, 1) == tft(1, 1)) &&
-            (sft(0, 2) == tft(0, 2)) &&
-            (sft(1, 2) == tft(1, 2));
-
-    bool inverted    =  (sft(0, 0) >= sft(0, 1)) ||
-            (sft(1, 0) >= sft(1, 1)) ||
-            (sft(2, 0) >= sft(2, 1));
-#endif
+    bool outsideMesh = false;
+    bool equalMesh = true;
+    bool inverted = false;
+
+    for (uint d = 0; d < D; ++d)
+    {
+        outsideMesh = outsideMesh || (sft(d, 0) < tft(d, 0)) || (sft(d, 1) > tft(d, 1));
+        equalMesh   = equalMesh && (sft(d, 0) == tft(d, 0)) && (sft(d, 1) == tft(d, 1));
+        inverted    = inverted || (sft(d, 0) >= sft(d, 1));
+    }
 
     return outsideMesh || equalMesh || inverted;
 
 }
 
-template<typename pT>
-void MeshField<pT>::setTopology(const topmat &topology, bool recursive)
+template<typename pT, uint D>
+void MeshField<pT, D>::setTopology(const topmat &topology, bool recursive)
 {
 
     if (recursive) {
-        for (MeshField<pT> * subField : m_subFields) {
+        for (MeshField<pT, D> * subField : m_subFields) {
             subField->scaleField(shape, this->topology, topology);
         }
     }
@@ -234,14 +272,14 @@ void MeshField<pT>::setTopology(const topmat &topology, bool recursive)
     new_volume = (pT*)(&volume);
 
     *new_volume = 1;
-    for (uint i = 0; i < IGNIS_DIM; ++i) {
+    for (uint i = 0; i < D; ++i) {
         *new_volume *= shape(i);
     }
 
 }
 
-template<typename pT>
-void MeshField<pT>::setTopology(const std::initializer_list<pT> topology, bool recursive)
+template<typename pT, uint D>
+void MeshField<pT, D>::setTopology(const std::initializer_list<pT> topology, bool recursive)
 {
     const topmat *newTop = new topmat(topology);
 
@@ -252,8 +290,8 @@ void MeshField<pT>::setTopology(const std::initializer_list<pT> topology, bool r
 }
 
 
-template<typename pT>
-void MeshField<pT>::addEvent(Event<pT> &event)
+template<typename pT, uint D>
+void MeshField<pT, D>::addEvent(Event<pT, D> &event)
 {
 
     event.setMeshField(this);
@@ -265,8 +303,8 @@ void MeshField<pT>::addEvent(Event<pT> &event)
 }
 
 
-template<typename pT>
-void MeshField<pT>::addSubField(MeshField<pT>  & subField)
+template<typename pT, uint D>
+void MeshField<pT, D>::addSubField(MeshField<pT, D>  & subField)
 {
 
     if (notCompatible(subField)) {
@@ -291,8 +329,8 @@ void MeshField<pT>::addSubField(MeshField<pT>  & subField)
 
 }
 
-template<typename pT>
-void MeshField<pT>::stretchField(double deltaL, uint xyz)
+template<typename pT, uint D>
+void MeshField<pT, D>::stretchField(double deltaL, uint xyz)
 {
 
     Mat<pT> newTopology = topology;
@@ -303,14 +341,14 @@ void MeshField<pT>::stretchField(double deltaL, uint xyz)
 
 }
 
-template<typename pT>
-void MeshField<pT>::scaleField(const Col<pT> & oldShape, const topmat &oldTopology, const topmat &newTopology){
+template<typename pT, uint D>
+void MeshField<pT, D>::scaleField(const Col<pT> & oldShape, const topmat &oldTopology, const topmat &newTopology){
 
-    Mat<pT> newSubTopology(IGNIS_DIM, 2);
+    Mat<pT> newSubTopology(D, 2);
 
     double oldCOM, newCOM, shapeFac, newShape_i, newSubShape_i;
 
-    for (uint i = 0; i < IGNIS_DIM; ++i) {
+    for (uint i = 0; i < D; ++i) {
 
         newShape_i = newTopology(i, 1) - newTopology(i, 0);
         shapeFac = newShape_i/oldShape(i);
@@ -330,8 +368,8 @@ void MeshField<pT>::scaleField(const Col<pT> & oldShape, const topmat &oldTopolo
 
 }
 
-template<typename pT>
-void MeshField<pT>::_prepareEvent(Event<pT> *event, const uint nCycles, const uint *loopCyclePtr)
+template<typename pT, uint D>
+void MeshField<pT, D>::_prepareEvent(Event<pT, D> *event, const uint nCycles, const uint *loopCyclePtr)
 {
     event->setValue(0);
 
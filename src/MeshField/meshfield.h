@@ -1,6 +1,6 @@
 #pragma once
 
-#include "../defines.h"
+#include "../forwards.h"
 
 #include <string>
 #include <vector>
@@ -16,23 +16,14 @@ using namespace arma;
 namespace ignis
 {
 
-template<typename pT>
-class PositionHandler;
-
-template<typename pT = double>
-class Event;
-
-template<typename pT = double>
-class MainMesh;
-
-template<typename pT>
+template<typename pT, uint D>
 class MeshField
 {
 public:
 
     typedef pT type;
-    typedef typename Mat<pT>::template fixed<IGNIS_DIM, 2> topmat;
-    typedef typename Col<pT>::template fixed<IGNIS_DIM>    shapevec;
+    typedef typename Mat<pT>::template fixed<D, 2> topmat;
+    typedef typename Col<pT>::template fixed<D>    shapevec;
 
     MeshField(const std::string description);
 
@@ -58,12 +49,12 @@ public:
         return false;
     }
 
-    void setParent(MeshField<pT> *parent)
+    void setParent(MeshField<pT, D> *parent)
     {
         this->m_parent = parent;
     }
 
-    MeshField<pT> *getParent ()
+    MeshField<pT, D> *getParent ()
     {
         return m_parent;
     }
@@ -71,21 +62,33 @@ public:
 
     virtual bool isWithinThis(uint i);
 
-    void addEvent(Event<pT> & event);
+    //! Fields overriding isWithinThis() with something other than the topology
+    //! box must return true here, so that box based containment shortcuts
+    //! (e.g. the spatial index) fall back to calling isWithinThis().
+    virtual bool hasCustomGeometry() const
+    {
+        return false;
+    }
 
-    void addEvent(Event<pT> * event)
+    //! Appends the particles in [first, last) which are within this field to indices,
+    //! using the vectorized box kernel when positions are contiguous.
+    void findWithinThis(std::vector<uint> &indices, const uint first = 0, uint last = IGNIS_UNSET_UINT);
+
+    void addEvent(Event<pT, D> & event);
+
+    void addEvent(Event<pT, D> * event)
     {
         addEvent(*event);
     }
 
-    bool hasEvent(const Event<pT> *event) const
+    bool hasEvent(const Event<pT, D> *event) const
     {
         return std::find(m_events.begin(), m_events.end(), event) != m_events.end();
     }
 
     void removeEvent(uint i);
 
-    void removeEvent(const Event<pT> *event);
+    void removeEvent(const Event<pT, D> *event);
 
     void addSubField(MeshField &subField);
 
@@ -126,7 +129,7 @@ public:
         return m_subFields;
     }
 
-    const std::vector<Event<pT> *> & getEvents() const
+    const std::vector<Event<pT, D> *> & getEvents() const
     {
         return m_events;
     }
@@ -141,9 +144,13 @@ public:
 
     virtual void stopLoop();
 
-    friend class MainMesh<pT>;
+    friend class MainMesh<pT, D>;
+
+    friend class ContainmentGrid<pT, D>;
 
-    virtual MainMesh<pT> *mainMesh()
+    friend class ContainmentTracker<pT, D>;
+
+    virtual MainMesh<pT, D> *mainMesh()
     {
         return m_parent->mainMesh();
     }
@@ -152,9 +159,9 @@ protected:
 
     const std::string m_description;
 
-    PositionHandler<pT> *m_particles;
+    PositionHandler<pT, D> *m_particles;
 
-    MeshField<pT> *m_parent;
+    MeshField<pT, D> *m_parent;
 
 
     const pT &particles(const uint n, const uint d)
@@ -164,14 +171,14 @@ protected:
 
     std::vector<uint> m_atoms;
 
-    std::vector<Event<pT>* > m_events;
+    std::vector<Event<pT, D>* > m_events;
 
-    std::vector<MeshField<pT>* > m_subFields;
+    std::vector<MeshField<pT, D>* > m_subFields;
 
 
-    void _prepareEvent(Event<pT> *event, const uint nCycles, const uint *loopCyclePtr);
+    void _prepareEvent(Event<pT, D> *event, const uint nCycles, const uint *loopCyclePtr);
 
-    virtual void _sendToTop(Event<pT> & event);
+    virtual void _sendToTop(Event<pT, D> & event);
 
 
     //This should be executed from the MainMesh,
@@ -182,8 +189,12 @@ protected:
 
     bool checkSubFields(uint i);
 
+    void _flattenSubFields(std::vector<MeshField<pT, D>*> &fields,
+                           std::vector<uint> &parents,
+                           const uint parent = IGNIS_UNSET_UINT) const;
+
 
-    bool notCompatible(MeshField<pT> & subField);
+    bool notCompatible(MeshField<pT, D> & subField);
 
     void resetSubFields();
 
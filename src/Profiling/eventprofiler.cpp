@@ -0,0 +1,280 @@
+#include "eventprofiler.h"
+
+#include "../Event/event.h"
+
+#include <BADAss/badass.h>
+
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+using namespace ignis;
+
+template<typename pT, uint D>
+EventProfiler<pT, D>::Timing::Timing() :
+    m_calls(0),
+    m_totalNs(0),
+    m_minNs(std::numeric_limits<uint64_t>::max()),
+    m_maxNs(0),
+    m_histogram(nBins, 0)
+{
+
+}
+
+template<typename pT, uint D>
+void EventProfiler<pT, D>::Timing::add(const uint64_t ns)
+{
+    m_calls++;
+    m_totalNs += ns;
+
+    m_minNs = std::min(m_minNs, ns);
+    m_maxNs = std::max(m_maxNs, ns);
+
+    m_histogram[bin(ns)]++;
+}
+
+template<typename pT, uint D>
+void EventProfiler<pT, D>::Timing::merge(const Timing &other)
+{
+    m_calls += other.m_calls;
+    m_totalNs += other.m_totalNs;
+
+    m_minNs = std::min(m_minNs, other.m_minNs);
+    m_maxNs = std::max(m_maxNs, other.m_maxNs);
+
+    for (uint i = 0; i < nBins; ++i)
+    {
+        m_histogram[i] += other.m_histogram[i];
+    }
+}
+
+template<typename pT, uint D>
+uint64_t EventProfiler<pT, D>::Timing::quantile(const double q) const
+{
+    if (m_calls == 0)
+    {
+        return 0;
+    }
+
+    const uint64_t rank = std::ceil(q*m_calls);
+
+    uint64_t count = 0;
+
+    for (uint i = 0; i < nBins; ++i)
+    {
+        count += m_histogram[i];
+
+        if (count >= rank)
+        {
+            return std::min(binUpperEdge(i), m_maxNs);
+        }
+    }
+
+    return m_maxNs;
+}
+
+template<typename pT, uint D>
+uint EventProfiler<pT, D>::Timing::bin(const uint64_t ns)
+{
+    if (ns < nSubBins)
+    {
+        return ns;
+    }
+
+    //The leading bit selects the octave and the two following bits the quarter.
+    const uint msb = 63 - __builtin_clzll(ns);
+
+    return msb*nSubBins + ((ns >> (msb - 2)) & (nSubBins - 1));
+}
+
+template<typename pT, uint D>
+uint64_t EventProfiler<pT, D>::Timing::binUpperEdge(const uint bin)
+{
+    if (bin < nSubBins)
+    {
+        return bin;
+    }
+
+    const uint msb = bin/nSubBins;
+    const uint64_t quarter = bin%nSubBins;
+
+    return ((uint64_t(nSubBins) + quarter + 1) << (msb - 2)) - 1;
+}
+
+template<typename pT, uint D>
+EventProfiler<pT, D>::EventProfiler(const uint nWorkers) :
+    m_nCycles(0)
+{
+    setWorkers(nWorkers);
+}
+
+template<typename pT, uint D>
+void EventProfiler<pT, D>::setWorkers(const uint nWorkers)
+{
+    BADAss(nWorkers, !=, 0);
+
+    m_execute.resize(nWorkers, std::vector<Timing>(m_names.size()));
+    m_reset.resize(nWorkers, std::vector<Timing>(m_names.size()));
+}
+
+template<typename pT, uint D>
+void EventProfiler<pT, D>::registerEvent(Event<pT, D> *event)
+{
+    const std::string name = event->description();
+
+    const uint slot = event->_profileSlot();
+
+    if (slot < m_names.size() && m_names[slot] == name)
+    {
+        return;
+    }
+
+    const auto existing = m_slots.find(name);
+
+    if (existing != m_slots.end())
+    {
+        event->_setProfileSlot(existing->second);
+        return;
+    }
+
+    m_slots[name] = m_names.size();
+    event->_setProfileSlot(m_names.size());
+
+    m_names.push_back(name);
+
+    for (uint worker = 0; worker < m_execute.size(); ++worker)
+    {
+        m_execute[worker].push_back(Timing());
+        m_reset[worker].push_back(Timing());
+    }
+}
+
+template<typename pT, uint D>
+void EventProfiler<pT, D>::clear()
+{
+    m_nCycles = 0;
+
+    for (uint worker = 0; worker < m_execute.size(); ++worker)
+    {
+        m_execute[worker].assign(m_names.size(), Timing());
+        m_reset[worker].assign(m_names.size(), Timing());
+    }
+
+    m_containment = Timing();
+}
+
+template<typename pT, uint D>
+typename EventProfiler<pT, D>::Timing EventProfiler<pT, D>::_merged(const std::vector<std::vector<Timing> > &timings, const uint slot) const
+{
+    Timing merged;
+
+    for (const std::vector<Timing> &workerTimings : timings)
+    {
+        merged.merge(workerTimings[slot]);
+    }
+
+    return merged;
+}
+
+template<typename pT, uint D>
+void EventProfiler<pT, D>::report(const std::string &path) const
+{
+    using namespace std;
+
+    struct Row
+    {
+        std::string m_name;
+        std::string m_phase;
+        Timing m_timing;
+    };
+
+    std::vector<Row> rows;
+
+    uint64_t totalNs = 0;
+
+    for (uint slot = 0; slot < m_names.size(); ++slot)
+    {
+        rows.push_back({m_names[slot], "execute", _merged(m_execute, slot)});
+        totalNs += rows.back().m_timing.m_totalNs;
+
+        rows.push_back({m_names[slot], "reset", _merged(m_reset, slot)});
+        totalNs += rows.back().m_timing.m_totalNs;
+    }
+
+    //Part of the particle handler's execute, so it is not added to the total.
+    rows.push_back({"containment", "update", m_containment});
+
+    //Most expensive first.
+    std::stable_sort(rows.begin(), rows.end(), [] (const Row &a, const Row &b)
+    {
+        return a.m_timing.m_totalNs > b.m_timing.m_totalNs;
+    });
+
+    cout << "ignis profile over " << m_nCycles << " cycles:" << endl;
+
+    cout << left << setw(50) << "event" << right
+         << setw(12) << "calls"
+         << setw(12) << "total ms"
+         << setw(8) << "%"
+         << setw(12) << "min ns"
+         << setw(12) << "mean ns"
+         << setw(12) << "p99 ns"
+         << setw(12) << "max ns" << endl;
+
+    std::ofstream csv(path + ".csv");
+    csv << "event,phase,calls,total_ns,min_ns,mean_ns,p99_ns,max_ns\n";
+
+    std::ofstream json(path + ".json");
+    json << "{\n  \"cycles\": " << m_nCycles << ",\n  \"timings\": [";
+
+    bool first = true;
+
+    for (const Row &row : rows)
+    {
+        const Timing &timing = row.m_timing;
+
+        if (timing.m_calls == 0)
+        {
+            continue;
+        }
+
+        const uint64_t mean = timing.m_totalNs/timing.m_calls;
+        const uint64_t p99 = timing.quantile(0.99);
+
+        cout << left << setw(50) << row.m_name + " " + row.m_phase << right
+             << setw(12) << timing.m_calls
+             << setw(12) << fixed << setprecision(3) << timing.m_totalNs*1E-6
+             << setw(8) << setprecision(1) << (totalNs == 0 ? 0 : 100.0*timing.m_totalNs/totalNs)
+             << setw(12) << timing.m_minNs
+             << setw(12) << mean
+             << setw(12) << p99
+             << setw(12) << timing.m_maxNs << endl;
+
+        csv << "\"" << row.m_name << "\"," << row.m_phase << ","
+            << timing.m_calls << ","
+            << timing.m_totalNs << ","
+            << timing.m_minNs << ","
+            << mean << ","
+            << p99 << ","
+            << timing.m_maxNs << "\n";
+
+        json << (first ? "\n" : ",\n")
+             << "    {\"event\": \"" << row.m_name << "\", \"phase\": \"" << row.m_phase << "\""
+             << ", \"calls\": " << timing.m_calls
+             << ", \"total_ns\": " << timing.m_totalNs
+             << ", \"min_ns\": " << timing.m_minNs
+             << ", \"mean_ns\": " << mean
+             << ", \"p99_ns\": " << p99
+             << ", \"max_ns\": " << timing.m_maxNs << "}";
+
+        first = false;
+    }
+
+    json << "\n  ]\n}\n";
+
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
@@ -0,0 +1,136 @@
+#pragma once
+
+#include "../forwards.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <stdint.h>
+
+namespace ignis
+{
+
+/*
+ * Per event timing of the event loop.
+ *
+ * Events are aggregated by description (type @ mesh field), so many
+ * short lived events of one kind share a row. Every timed call costs two
+ * steady_clock reads and a histogram update. Latencies are binned in
+ * quarter octaves, which bounds the error of the reported p99 to 19%.
+ * Each worker of the event pool records into its own tables, which are
+ * merged when reporting.
+ */
+
+template<typename pT, uint D>
+class EventProfiler
+{
+public:
+
+    typedef std::chrono::steady_clock Clock;
+
+    struct Timing
+    {
+        enum
+        {
+            nSubBins = 4,
+            nBins = 64*nSubBins
+        };
+
+        uint64_t m_calls;
+        uint64_t m_totalNs;
+        uint64_t m_minNs;
+        uint64_t m_maxNs;
+
+        std::vector<uint32_t> m_histogram;
+
+        Timing();
+
+        void add(const uint64_t ns);
+
+        void merge(const Timing &other);
+
+        //! Upper edge of the bin holding quantile q.
+        uint64_t quantile(const double q) const;
+
+        static uint bin(const uint64_t ns);
+
+        static uint64_t binUpperEdge(const uint bin);
+    };
+
+    EventProfiler(const uint nWorkers = 1);
+
+    void setWorkers(const uint nWorkers);
+
+    //! Assigns the event a row. Must not be called concurrently with timing.
+    void registerEvent(Event<pT, D> *event);
+
+    void clear();
+
+    void execute(Event<pT, D> *event, const uint worker = 0)
+    {
+        const Clock::time_point start = Clock::now();
+
+        event->execute();
+
+        _record(m_execute, event, worker, start);
+    }
+
+    void reset(Event<pT, D> *event)
+    {
+        const Clock::time_point start = Clock::now();
+
+        event->reset();
+
+        _record(m_reset, event, 0, start);
+    }
+
+    void recordContainment(const Clock::time_point start)
+    {
+        m_containment.add(_elapsed(start));
+    }
+
+    void countCycle()
+    {
+        m_nCycles++;
+    }
+
+    //! Prints a table and writes path.json and path.csv.
+    void report(const std::string &path) const;
+
+private:
+
+    uint64_t m_nCycles;
+
+    std::vector<std::string> m_names;
+
+    std::map<std::string, uint> m_slots;
+
+    //! [worker][slot]
+    std::vector<std::vector<Timing> > m_execute;
+
+    std::vector<std::vector<Timing> > m_reset;
+
+    Timing m_containment;
+
+
+    static uint64_t _elapsed(const Clock::time_point start)
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+    }
+
+    void _record(std::vector<std::vector<Timing> > &timings,
+                 const Event<pT, D> *event,
+                 const uint worker,
+                 const Clock::time_point start)
+    {
+        timings[worker][event->_profileSlot()].add(_elapsed(start));
+    }
+
+    Timing _merged(const std::vector<std::vector<Timing> > &timings, const uint slot) const;
+
+};
+
+}
+
+#include "eventprofiler.cpp"
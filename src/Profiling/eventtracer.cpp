@@ -0,0 +1,144 @@
+#include "eventtracer.h"
+
+#include "../Event/event.h"
+
+#include <BADAss/badass.h>
+
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+using namespace ignis;
+
+template<typename pT, uint D>
+EventTracer<pT, D>::EventTracer(const uint sampleInterval, const uint maxRecords) :
+    m_sampleInterval(sampleInterval),
+    m_maxRecords(maxRecords),
+    m_cycle(0),
+    m_sampling(true)
+{
+    BADAss(sampleInterval, !=, 0, "Zero sample interval is not allowed.");
+
+    _intern("containment update");
+}
+
+template<typename pT, uint D>
+void EventTracer<pT, D>::start(const uint nWorkers)
+{
+    BADAss(nWorkers, !=, 0);
+
+    m_buffers.resize(nWorkers + 1);
+
+    for (Buffer &buffer : m_buffers)
+    {
+        buffer.m_records.clear();
+        buffer.m_records.reserve(m_maxRecords);
+        buffer.m_nDropped = 0;
+    }
+
+    m_origin = Clock::now();
+
+    beginCycle(0);
+}
+
+template<typename pT, uint D>
+void EventTracer<pT, D>::registerEvent(const Event<pT, D> *event)
+{
+    m_eventNames[event] = _intern(event->description());
+}
+
+template<typename pT, uint D>
+void EventTracer<pT, D>::recordChunk(const uint firstCycle, const uint lastCycle, const Clock::time_point start)
+{
+    std::stringstream name;
+    name << "chunk [" << firstCycle << ", " << lastCycle << "]";
+
+    _push(m_buffers.front(), _intern(name.str()), Category::Chunk, firstCycle, start);
+}
+
+template<typename pT, uint D>
+uint64_t EventTracer<pT, D>::nDropped() const
+{
+    uint64_t nDropped = 0;
+
+    for (const Buffer &buffer : m_buffers)
+    {
+        nDropped += buffer.m_nDropped;
+    }
+
+    return nDropped;
+}
+
+template<typename pT, uint D>
+uint EventTracer<pT, D>::_intern(const std::string &name)
+{
+    const auto existing = m_nameIndices.find(name);
+
+    if (existing != m_nameIndices.end())
+    {
+        return existing->second;
+    }
+
+    m_nameIndices[name] = m_names.size();
+    m_names.push_back(name);
+
+    return m_names.size() - 1;
+}
+
+template<typename pT, uint D>
+void EventTracer<pT, D>::write(const std::string &path) const
+{
+    static const char *categories[] = {"execute", "reset", "containment", "chunk", "write"};
+
+    std::ofstream file(path);
+
+    file << "{\"displayTimeUnit\": \"ns\",\n"
+         << "\"otherData\": {\"sampleInterval\": " << m_sampleInterval << ", \"droppedRecords\": " << nDropped() << "},\n"
+         << "\"traceEvents\": [";
+
+    for (uint thread = 0; thread < m_buffers.size(); ++thread)
+    {
+        file << (thread == 0 ? "\n" : ",\n")
+             << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread
+             << ", \"args\": {\"name\": \""
+             << (thread + 1 == m_buffers.size() ? std::string("event storage") : "event thread " + std::to_string(thread))
+             << "\"}}";
+    }
+
+    file << std::fixed << std::setprecision(3);
+
+    for (uint thread = 0; thread < m_buffers.size(); ++thread)
+    {
+        for (const Record &record : m_buffers[thread].m_records)
+        {
+            const uint category = static_cast<uint>(record.m_category);
+
+            file << ",\n{\"name\": \"";
+
+            if (record.m_category == Category::Write)
+            {
+                file << "write " << record.m_name << " values";
+            }
+
+            else
+            {
+                file << m_names[record.m_name];
+            }
+
+            //Timestamps are in microseconds.
+            file << "\", \"cat\": \"" << categories[category]
+                 << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << thread
+                 << ", \"ts\": " << record.m_start*1E-3
+                 << ", \"dur\": " << record.m_duration*1E-3;
+
+            if (record.m_cycle != IGNIS_UNSET_UINT)
+            {
+                file << ", \"args\": {\"cycle\": " << record.m_cycle << "}";
+            }
+
+            file << "}";
+        }
+    }
+
+    file << "\n]}\n";
+}
@@ -0,0 +1,155 @@
+#pragma once
+
+#include "../forwards.h"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <stdint.h>
+
+namespace ignis
+{
+
+/*
+ * Timeline of the event loop in the Chrome trace event format, viewable in
+ * chrome://tracing or Perfetto.
+ *
+ * Every thread appends fixed size records to its own preallocated buffer,
+ * so recording takes no locks and never allocates: event pool worker k
+ * uses buffer k, and the thread writing event storage the last one. Full
+ * buffers drop further records. Only every sampleInterval'th cycle is
+ * traced, which keeps long runs within the buffers. Names are resolved
+ * and the JSON formatted only when the trace is written.
+ */
+
+template<typename pT, uint D>
+class EventTracer
+{
+public:
+
+    typedef std::chrono::steady_clock Clock;
+
+    enum class Category : uint
+    {
+        Execute,
+        Reset,
+        Containment,
+        Chunk,
+        Write
+    };
+
+    EventTracer(const uint sampleInterval = 1, const uint maxRecords = 1 << 18);
+
+    //! Clears the buffers and restarts the clock. nWorkers buffers are kept for the event threads.
+    void start(const uint nWorkers);
+
+    //! Must not be called concurrently with recording.
+    void registerEvent(const Event<pT, D> *event);
+
+    void beginCycle(const uint cycle)
+    {
+        m_cycle = cycle;
+        m_sampling = cycle%m_sampleInterval == 0;
+    }
+
+    bool sampling() const
+    {
+        return m_sampling;
+    }
+
+    void record(const Event<pT, D> *event,
+                const Category category,
+                const uint worker,
+                const Clock::time_point start)
+    {
+        _push(m_buffers[worker], m_eventNames.find(event)->second, category, m_cycle, start);
+    }
+
+    void recordContainment(const Clock::time_point start)
+    {
+        _push(m_buffers.front(), 0, Category::Containment, m_cycle, start);
+    }
+
+    //! Chunks are recorded regardless of sampling.
+    void recordChunk(const uint firstCycle, const uint lastCycle, const Clock::time_point start);
+
+    //! Called from the thread writing event storage, so the cycle is not known.
+    void recordWrite(const uint64_t nValues, const Clock::time_point start)
+    {
+        _push(m_buffers.back(), nValues, Category::Write, IGNIS_UNSET_UINT, start);
+    }
+
+    uint64_t nDropped() const;
+
+    void write(const std::string &path) const;
+
+private:
+
+    struct Record
+    {
+        //! Index into m_names, the number of values for writes.
+        uint64_t m_name;
+        int64_t m_start;
+        int64_t m_duration;
+        uint m_cycle;
+        Category m_category;
+    };
+
+    struct Buffer
+    {
+        std::vector<Record> m_records;
+        uint64_t m_nDropped;
+
+        //! Keeps the buffers of different threads on separate cache lines.
+        char m_padding[64];
+    };
+
+    const uint m_sampleInterval;
+
+    const uint m_maxRecords;
+
+    Clock::time_point m_origin;
+
+    uint m_cycle;
+
+    bool m_sampling;
+
+    std::vector<Buffer> m_buffers;
+
+    std::vector<std::string> m_names;
+
+    std::map<std::string, uint> m_nameIndices;
+
+    std::unordered_map<const Event<pT, D> *, uint> m_eventNames;
+
+
+    uint _intern(const std::string &name);
+
+    void _push(Buffer &buffer,
+               const uint64_t name,
+               const Category category,
+               const uint cycle,
+               const Clock::time_point start)
+    {
+        const Clock::time_point end = Clock::now();
+
+        if (buffer.m_records.size() == m_maxRecords)
+        {
+            buffer.m_nDropped++;
+            return;
+        }
+
+        buffer.m_records.push_back({name,
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(start - m_origin).count(),
+                                    std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count(),
+                                    cycle,
+                                    category});
+    }
+
+};
+
+}
+
+#include "eventtracer.cpp"
@@ -0,0 +1,138 @@
+#pragma once
+
+#include "eventprofiler.h"
+
+#include "eventtracer.h"
+
+namespace ignis
+{
+
+/*
+ * The optional profiler and tracer of an event loop, so that the paths
+ * executing events only branch once when neither is enabled.
+ */
+
+template<typename pT, uint D>
+struct Instrumentation
+{
+    EventProfiler<pT, D> *m_profiler;
+
+    EventTracer<pT, D> *m_tracer;
+
+    Instrumentation() :
+        m_profiler(nullptr),
+        m_tracer(nullptr)
+    {
+
+    }
+
+    bool enabled() const
+    {
+        return m_profiler != nullptr || m_tracer != nullptr;
+    }
+
+    void registerEvent(Event<pT, D> *event) const
+    {
+        if (m_profiler != nullptr)
+        {
+            m_profiler->registerEvent(event);
+        }
+
+        if (m_tracer != nullptr)
+        {
+            m_tracer->registerEvent(event);
+        }
+    }
+
+    void beginCycle(const uint cycle) const
+    {
+        if (m_profiler != nullptr)
+        {
+            m_profiler->countCycle();
+        }
+
+        if (m_tracer != nullptr)
+        {
+            m_tracer->beginCycle(cycle);
+        }
+    }
+
+    void execute(Event<pT, D> *event, const uint worker = 0) const
+    {
+        if (m_tracer == nullptr || !m_tracer->sampling())
+        {
+            _execute(event, worker);
+            return;
+        }
+
+        const auto start = EventTracer<pT, D>::Clock::now();
+
+        _execute(event, worker);
+
+        m_tracer->record(event, EventTracer<pT, D>::Category::Execute, worker, start);
+    }
+
+    void reset(Event<pT, D> *event) const
+    {
+        if (m_tracer == nullptr || !m_tracer->sampling())
+        {
+            _reset(event);
+            return;
+        }
+
+        const auto start = EventTracer<pT, D>::Clock::now();
+
+        _reset(event);
+
+        m_tracer->record(event, EventTracer<pT, D>::Category::Reset, 0, start);
+    }
+
+    template<typename updateFunc>
+    void updateContainments(updateFunc update) const
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        update();
+
+        if (m_profiler != nullptr)
+        {
+            m_profiler->recordContainment(start);
+        }
+
+        if (m_tracer != nullptr && m_tracer->sampling())
+        {
+            m_tracer->recordContainment(start);
+        }
+    }
+
+private:
+
+    void _execute(Event<pT, D> *event, const uint worker) const
+    {
+        if (m_profiler == nullptr)
+        {
+            event->execute();
+        }
+
+        else
+        {
+            m_profiler->execute(event, worker);
+        }
+    }
+
+    void _reset(Event<pT, D> *event) const
+    {
+        if (m_profiler == nullptr)
+        {
+            event->reset();
+        }
+
+        else
+        {
+            m_profiler->reset(event);
+        }
+    }
+
+};
+
+}
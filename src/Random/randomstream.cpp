@@ -0,0 +1,103 @@
+#include "randomstream.h"
+
+using namespace ignis;
+
+inline RandomStream::RandomStream(const uint64_t seed, const uint64_t stream) :
+    m_seed(seed),
+    m_stream(stream),
+    m_position(0)
+{
+
+}
+
+inline void RandomStream::philox(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4])
+{
+    uint32_t c0 = counter[0];
+    uint32_t c1 = counter[1];
+    uint32_t c2 = counter[2];
+    uint32_t c3 = counter[3];
+
+    uint32_t k0 = key[0];
+    uint32_t k1 = key[1];
+
+    for (uint round = 0; round < 10; ++round)
+    {
+        const uint64_t p0 = uint64_t(0xD2511F53)*c0;
+        const uint64_t p1 = uint64_t(0xCD9E8D57)*c2;
+
+        c0 = uint32_t(p1 >> 32) ^ c1 ^ k0;
+        c1 = uint32_t(p1);
+        c2 = uint32_t(p0 >> 32) ^ c3 ^ k1;
+        c3 = uint32_t(p0);
+
+        //Weyl sequence key schedule.
+        k0 += 0x9E3779B9;
+        k1 += 0xBB67AE85;
+    }
+
+    result[0] = c0;
+    result[1] = c1;
+    result[2] = c2;
+    result[3] = c3;
+}
+
+inline RandomStream RandomStream::substream(const uint64_t id) const
+{
+    //SplitMix64 finalizer, spreading nearby ids over the whole stream space.
+    uint64_t z = m_stream + 0x9E3779B97F4A7C15ull*(id + 1);
+
+    z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27))*0x94D049BB133111EBull;
+
+    return RandomStream(m_seed, z ^ (z >> 31));
+}
+
+inline void RandomStream::block(const uint64_t index, uint32_t result[4]) const
+{
+    const uint32_t counter[4] = {uint32_t(index), uint32_t(index >> 32), uint32_t(m_stream), uint32_t(m_stream >> 32)};
+    const uint32_t key[2] = {uint32_t(m_seed), uint32_t(m_seed >> 32)};
+
+    philox(counter, key, result);
+}
+
+inline double RandomStream::uniform(const uint64_t index) const
+{
+    uint32_t words[4];
+
+    block(index/2, words);
+
+    return index%2 == 0 ? _toUniform(words[0], words[1]) : _toUniform(words[2], words[3]);
+}
+
+template<typename T>
+void RandomStream::fillUniform(T *out, const uint64_t first, const uint n, const T low, const T high, const uint stride) const
+{
+    const double width = double(high) - double(low);
+
+    uint k = 0;
+
+    //An odd first index starts in the second half of its block.
+    if (n != 0 && first%2 == 1)
+    {
+        out[0] = low + T(width*uniform(first));
+        k = 1;
+    }
+
+    const uint64_t firstBlock = (first + k)/2;
+    const uint nBlocks = (n - k)/2;
+
+    for (uint b = 0; b < nBlocks; ++b)
+    {
+        uint32_t words[4];
+
+        block(firstBlock + b, words);
+
+        out[(k + 2*b)*stride] = low + T(width*_toUniform(words[0], words[1]));
+        out[(k + 2*b + 1)*stride] = low + T(width*_toUniform(words[2], words[3]));
+    }
+
+    for (k += 2*nBlocks; k < n; ++k)
+    {
+        out[k*stride] = low + T(width*uniform(first + k));
+    }
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "../defines.h"
+
+#include <stdint.h>
+
+namespace ignis
+{
+
+/*
+ * Counter based random numbers (Philox4x32-10, Salmon et al., SC'11).
+ *
+ * Value k of a stream is a pure function of (seed, stream, k), so any
+ * element can be drawn directly, in any order and on any thread. Work
+ * split over threads therefore gives bitwise identical results for every
+ * thread count, as long as each item draws at indices derived from the
+ * item itself (e.g. the particle index) rather than from its thread.
+ *
+ * The seed is the 64 bit Philox key, and the counter holds the 64 bit
+ * stream id next to the 64 bit block index. Each block yields two doubles.
+ */
+
+class RandomStream
+{
+public:
+
+    RandomStream(const uint64_t seed = 0, const uint64_t stream = 0);
+
+    //! The Philox4x32-10 bijection of counter under key.
+    static void philox(const uint32_t counter[4], const uint32_t key[2], uint32_t result[4]);
+
+    const uint64_t &seed() const
+    {
+        return m_seed;
+    }
+
+    const uint64_t &stream() const
+    {
+        return m_stream;
+    }
+
+    //! An independent stream, e.g. one per dimension or per work item.
+    RandomStream substream(const uint64_t id) const;
+
+    //! The four random words of block index.
+    void block(const uint64_t index, uint32_t result[4]) const;
+
+    //! Uniform in [0, 1) with 53 random bits, value index of the stream.
+    double uniform(const uint64_t index) const;
+
+    //! out[k*stride] = low + (high - low)*uniform(first + k) for k < n.
+    template<typename T>
+    void fillUniform(T *out, const uint64_t first, const uint n, const T low = 0, const T high = 1, const uint stride = 1) const;
+
+    //! Sequential draws, continuing from seek().
+    double operator() ()
+    {
+        return uniform(m_position++);
+    }
+
+    void seek(const uint64_t position)
+    {
+        m_position = position;
+    }
+
+private:
+
+    uint64_t m_seed;
+
+    uint64_t m_stream;
+
+    uint64_t m_position;
+
+    static double _toUniform(const uint32_t high, const uint32_t low)
+    {
+        return ((uint64_t(high) << 21) ^ (low >> 11))*(1.0/9007199254740992.0);
+    }
+
+};
+
+}
+
+#include "randomstream.cpp"
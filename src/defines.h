@@ -3,6 +3,7 @@
 #include <limits>
 #include <sys/types.h>
 
+//! Default dimension D of meshes, events and position handlers.
 #ifndef IGNIS_DIM
 #define IGNIS_DIM 3
 #endif
@@ -12,3 +13,8 @@ const uint IGNIS_Y = 1;
 const uint IGNIS_Z = 2;
 
 const uint IGNIS_UNSET_UINT = std::numeric_limits<uint>::max();
+
+//! Shared state events can declare access to (Event::declareAccess).
+const uint IGNIS_POSITIONS = 1;
+const uint IGNIS_CONTAINMENT = 2;
+const uint IGNIS_TOPOLOGY = 4;
@@ -0,0 +1,55 @@
+#pragma once
+
+#include "defines.h"
+
+namespace ignis
+{
+
+/*
+ * Declarations of the library's class templates.
+ *
+ * The dimension D is a template parameter, so one build serves meshes
+ * and events of any dimension side by side. It defaults to IGNIS_DIM,
+ * which lets single dimension code keep writing e.g. MainMesh<double>.
+ */
+
+template<typename pT, uint D = IGNIS_DIM>
+struct PositionSpan;
+
+template<typename pT, uint D = IGNIS_DIM>
+class PositionView;
+
+template<typename pT, uint D = IGNIS_DIM>
+class PositionHandler;
+
+template<typename pT, uint D = IGNIS_DIM>
+class MeshField;
+
+template<typename pT = double, uint D = IGNIS_DIM>
+class Event;
+
+template<typename pT = double, uint D = IGNIS_DIM>
+class MainMesh;
+
+template<typename pT, uint D = IGNIS_DIM>
+class ContainmentGrid;
+
+template<typename pT, uint D = IGNIS_DIM>
+class ContainmentTracker;
+
+template<typename pT, uint D = IGNIS_DIM>
+class EventGraph;
+
+template<typename pT, uint D = IGNIS_DIM>
+struct Instrumentation;
+
+template<typename pT, uint D = IGNIS_DIM>
+class EventProfiler;
+
+template<typename pT, uint D = IGNIS_DIM>
+class EventTracer;
+
+template<typename pT, uint D = IGNIS_DIM>
+class _particleHandler;
+
+}
@@ -1,12 +1,16 @@
 #pragma once
 
+#include "forwards.h"
+
 #include <armadillo>
 
-#define REGISTER_POSITIONHANDLER(handler, type) \
+//! Gives an event typed access to its position handler. The event's
+//! dimension is D, or IGNIS_DIM for REGISTER_POSITIONHANDLER.
+#define REGISTER_POSITIONHANDLER_D(handler, type, D) \
 protected: \
     handler & registeredHandler() const\
     { \
-        return *static_cast<handler*>(&Event<type>::registeredHandler()); \
+        return *static_cast<handler*>(&Event<type, D>::registeredHandler()); \
     } \
     \
     type registeredHandler(const uint n, const uint d) \
@@ -16,14 +20,154 @@ protected: \
 \
 private: \
 
+#define REGISTER_POSITIONHANDLER(handler, type) REGISTER_POSITIONHANDLER_D(handler, type, IGNIS_DIM)
+
 namespace ignis
 {
 
-template<typename pT>
+//! Direct view of contiguous position storage. Coordinate d of particle n is
+//! found at data[n*particleStride + d*dimensionStride], which covers both
+//! array-of-structs (AoS) and struct-of-arrays (SoA) layouts.
+template<typename pT, uint D>
+struct PositionSpan
+{
+    pT *data;
+
+    uint particleStride;
+
+    uint dimensionStride;
+
+    bool valid() const
+    {
+        return data != nullptr;
+    }
+
+    pT &operator() (const uint n, const uint d) const
+    {
+        return data[n*particleStride + d*dimensionStride];
+    }
+
+    static PositionSpan<pT, D> none()
+    {
+        return {nullptr, 0, 0};
+    }
+
+    //! Layout x0 y0 z0 x1 y1 z1 ...
+    static PositionSpan<pT, D> AoS(pT *data)
+    {
+        return {data, D, 1};
+    }
+
+    //! Layout x0 x1 ... xN y0 y1 ... yN ...
+    static PositionSpan<pT, D> SoA(pT *data, const uint count)
+    {
+        return {data, 1, count};
+    }
+
+};
+
+//! Fixed size read/write proxy for the coordinates of a single particle.
+//! Holds pointers straight into the handler's storage, so it never allocates.
+template<typename pT, uint D>
+class PositionView
+{
+
+    typedef typename arma::Col<pT>::template fixed<D> colType;
+
+public:
+
+    PositionView(PositionHandler<pT, D> &handler, const uint n);
+
+    uint index() const
+    {
+        return m_index;
+    }
+
+    pT operator() (const uint d) const
+    {
+        return *m_coordinates[d];
+    }
+
+    pT &operator() (const uint d)
+    {
+        return *m_coordinates[d];
+    }
+
+    operator colType () const
+    {
+        colType col;
+
+        for (uint d = 0; d < D; ++d)
+        {
+            col(d) = *m_coordinates[d];
+        }
+
+        return col;
+    }
+
+    PositionView &operator = (const colType &col)
+    {
+        for (uint d = 0; d < D; ++d)
+        {
+            *m_coordinates[d] = col(d);
+        }
+
+        return *this;
+    }
+
+    PositionView &operator += (const colType &col)
+    {
+        for (uint d = 0; d < D; ++d)
+        {
+            *m_coordinates[d] += col(d);
+        }
+
+        return *this;
+    }
+
+    PositionView &operator -= (const colType &col)
+    {
+        for (uint d = 0; d < D; ++d)
+        {
+            *m_coordinates[d] -= col(d);
+        }
+
+        return *this;
+    }
+
+    PositionView &operator *= (const pT scale)
+    {
+        for (uint d = 0; d < D; ++d)
+        {
+            *m_coordinates[d] *= scale;
+        }
+
+        return *this;
+    }
+
+    PositionView &operator /= (const pT scale)
+    {
+        for (uint d = 0; d < D; ++d)
+        {
+            *m_coordinates[d] /= scale;
+        }
+
+        return *this;
+    }
+
+private:
+
+    const uint m_index;
+
+    pT *m_coordinates[D];
+
+};
+
+template<typename pT, uint D>
 class PositionHandler
 {
 
-    typedef typename arma::Col<pT>::template fixed<IGNIS_DIM> colType;
+    typedef typename arma::Col<pT>::template fixed<D> colType;
 
 
 public:
@@ -36,29 +180,56 @@ public:
 
     virtual pT &operator() (const uint n, const uint d) = 0;
 
+    //! Handlers storing positions contiguously should return a span over them,
+    //! letting built-in events and containment updates bypass the per
+    //! coordinate virtual calls. The span must stay valid until positions are
+    //! reallocated; it is requested anew every cycle.
+    virtual PositionSpan<pT, D> span()
+    {
+        return PositionSpan<pT, D>::none();
+    }
 
-    colType & vec(const uint n) const
+
+    PositionView<pT, D> vec(const uint n)
     {
-        colType* _col = new colType;
+        return PositionView<pT, D>(*this, n);
+    }
 
-        (*_col)(0) = (*this)(n, 0);
-        (*_col)(1) = (*this)(n, 1);
-#if INGIS_DIM == 3
-        (*_col)(2) = (*this)(n, 2);
-#endif
+    colType vec(const uint n) const
+    {
+        colType col;
 
-        return *_col;
+        for (uint d = 0; d < D; ++d)
+        {
+            col(d) = (*this)(n, d);
+        }
 
+        return col;
     }
 
     operator arma::Mat<pT> () const
     {
 
-        arma::Mat<pT> m(count(), IGNIS_DIM);
+        arma::Mat<pT> m(count(), D);
+
+        const PositionSpan<pT, D> positions = const_cast<PositionHandler<pT, D>*>(this)->span();
+
+        if (positions.valid())
+        {
+            for (uint j = 0; j < D; ++j)
+            {
+                for(uint i = 0; i < count(); ++i)
+                {
+                    m(i, j) = positions(i, j);
+                }
+            }
+
+            return m;
+        }
 
         for(uint i = 0; i < count(); ++i)
         {
-            for (uint j = 0; j < IGNIS_DIM; ++j)
+            for (uint j = 0; j < D; ++j)
             {
                 m(i, j) = (*this)(i, j);
             }
@@ -70,12 +241,24 @@ public:
 
 };
 
-template<typename pT>
-class DummyHandler : public PositionHandler<pT>
+template<typename pT, uint D>
+PositionView<pT, D>::PositionView(PositionHandler<pT, D> &handler, const uint n) :
+    m_index(n)
+{
+    const PositionSpan<pT, D> positions = handler.span();
+
+    for (uint d = 0; d < D; ++d)
+    {
+        m_coordinates[d] = positions.valid() ? &positions(n, d) : &handler(n, d);
+    }
+}
+
+template<typename pT, uint D = IGNIS_DIM>
+class DummyHandler : public PositionHandler<pT, D>
 {
 private:
 
-    pT* data[10][IGNIS_DIM];
+    pT* data[10][D];
 
     // PositionHandler interface
 public:
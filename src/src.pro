@@ -1,5 +1,7 @@
 include(../defaults.pri)
 
+#Changes the default dimension only. Meshes of other dimensions are
+#available through the D template parameter, e.g. MainMesh<double, 2>.
 #CONFIG += 2D
 
 TEMPLATE = lib 
@@ -10,6 +12,7 @@ VERSION = 2.0.0
 
 HEADERS += \
     defines.h \
+    forwards.h \
     Particles/particles.h \
     MeshField/meshfield.h \
     Event/event.h \
@@ -17,13 +20,43 @@ HEADERS += \
     MeshField/MainMesh/intrinsicevents.h \
     Event/predefinedevents.h \
     positionhandler.h \
-    Event/dcvizevents.h
+    Event/dcvizevents.h \
+    MeshField/MainMesh/containmentgrid.h \
+    MeshField/MainMesh/containmenttracker.h \
+    MeshField/boxkernel.h \
+    IO/ignwriter.h \
+    IO/ignreader.h \
+    IO/ignformat.h \
+    IO/igncodec.h \
+    IO/spscqueue.h \
+    IO/asyncreporter.h \
+    Event/workstealingpool.h \
+    Event/eventgraph.h \
+    Event/timingwheel.h \
+    Profiling/eventprofiler.h \
+    Profiling/eventtracer.h \
+    Profiling/instrumentation.h \
+    Random/randomstream.h
 
 
 OTHER_FILES += \
     MeshField/meshfield.cpp \
     Event/event.cpp \
-    MeshField/MainMesh/mainmesh.cpp
+    MeshField/MainMesh/mainmesh.cpp \
+    MeshField/MainMesh/containmentgrid.cpp \
+    MeshField/MainMesh/containmenttracker.cpp \
+    IO/ignwriter.cpp \
+    IO/ignreader.cpp \
+    IO/ignformat.cpp \
+    IO/igncodec.cpp \
+    IO/spscqueue.cpp \
+    IO/asyncreporter.cpp \
+    Event/workstealingpool.cpp \
+    Event/eventgraph.cpp \
+    Event/timingwheel.cpp \
+    Profiling/eventprofiler.cpp \
+    Profiling/eventtracer.cpp \
+    Random/randomstream.cpp
 
 
 
@@ -66,4 +66,89 @@ protected:
     }
 };
 
+class ChainedValue : public MeshEvent
+{
+public:
+
+    ChainedValue(const double f, const ChainedValue *previous = nullptr) :
+        MeshEvent("ChainedValue", "", false, true),
+        m_f(f)
+    {
+        declareAccess(0, 0);
+
+        if (previous != nullptr)
+        {
+            m_previous = setDependency(previous);
+        }
+    }
+
+private:
+
+    const double m_f;
+
+    DependencyHandle<ChainedValue> m_previous;
+
+    // Event interface
+protected:
+    void execute()
+    {
+        const double base = m_previous.valid() ? dependency(m_previous)->value() : 0;
+
+        setValue(base + m_f*cycle());
+    }
+};
+
+class OutputValue : public MeshEvent
+{
+public:
+
+    OutputValue(const double f) :
+        MeshEvent("OutputValue", "m", true),
+        m_f(f)
+    {
+
+    }
+
+private:
+
+    const double m_f;
+
+    // Event interface
+protected:
+    void execute()
+    {
+        //Only every other cycle reports a value.
+        if (cycle()%2 == 0)
+        {
+            setValue(m_f*cycle());
+        }
+    }
+};
+
+//! Sums the last coordinate through the typed handler of a D dimensional system.
+template<uint D>
+class DimensionSum : public Event<double, D>
+{
+    REGISTER_POSITIONHANDLER_D(DimensionTestSystem<D>, double, D)
+
+public:
+
+    DimensionSum() : Event<double, D>("DimensionSum", "", true)
+    {
+
+    }
+
+    void execute()
+    {
+        double sum = 0;
+
+        for (uint n = 0; n < registeredHandler().count(); ++n)
+        {
+            sum += registeredHandler()(n, D - 1);
+        }
+
+        this->setValue(sum);
+    }
+};
+
 }
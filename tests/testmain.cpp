@@ -52,7 +52,7 @@ TEST(saveAndLoad)
     mesh.enableEventValueStorage(true, true, filename);
 
     uint K = 10;
-    vector<SaveData*> saveDataEvents(K);
+    vector<SaveData*> saveDataEvents;
     for (uint i = 0; i < K; ++i)
     {
         SaveData *saveDataEvent = new SaveData(i + 1);
@@ -79,6 +79,94 @@ TEST(saveAndLoad)
         }
     }
 
+    IgnReader reader(path);
+
+    CHECK_EQUAL(nCycles, reader.nRows());
+    CHECK_EQUAL(K, reader.nCols());
+    CHECK_EQUAL(IgnHeader::currentVersion, reader.header().m_version);
+    CHECK_EQUAL(K, reader.units().size());
+    CHECK_EQUAL(3*4, reader(3, 3));
+    CHECK_EQUAL(2*7, reader.column(6)(2));
+
+    reader.forEachBlock(2, [&] (const uint first, const mat &block)
+    {
+        for (uint i = 0; i < block.n_cols; ++i)
+        {
+            CHECK_EQUAL(loadMatrix(first + i, K - 1), block(K - 1, i));
+        }
+    });
+
+    for (SaveData* event : saveDataEvents)
+    {
+        mesh.removeEvent(event);
+        delete event;
+    }
+
+}
+
+TEST(compressedStorage)
+{
+    vector<double> series(1000);
+
+    series[0] = 1.0;
+    for (uint i = 1; i < series.size(); ++i)
+    {
+        series[i] = (i >= 100 && i < 200) ? series[i - 1] : series[i - 1] + 0.01*sin(0.1*i);
+    }
+
+    string encoded;
+    XorCodec::encode(series.data(), series.size(), 1, encoded);
+
+    CHECK(encoded.size() < series.size()*sizeof(double));
+
+    vector<double> decoded(series.size());
+    XorCodec::decode(encoded.data(), encoded.size(), series.size(), decoded.data(), 1);
+
+    CHECK(decoded == series);
+
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(false);
+
+    string filename = "ignis_test_compressed.ign";
+    mesh.enableEventValueStorage(true, true, filename);
+    mesh.setEventStorageCompression(3);
+
+    uint K = 5;
+    vector<SaveData*> saveDataEvents;
+    for (uint i = 0; i < K; ++i)
+    {
+        saveDataEvents.push_back(new SaveData(0.1*(i + 1)));
+        mesh.addEvent(saveDataEvents.back());
+    }
+
+    uint nCycles = 10;
+    mesh.eventLoop(nCycles);
+
+    IgnReader reader(mesh.outputPath() + filename);
+
+    CHECK(reader.compressed());
+    CHECK_EQUAL(nCycles, reader.nRows());
+    CHECK_EQUAL(K, reader.nCols());
+
+    for (uint i = 0; i < nCycles; ++i)
+    {
+        for (uint k = 0; k < K; ++k)
+        {
+            CHECK_EQUAL(mesh.storedEventValues()(i, k), reader(i, k));
+        }
+    }
+
+    vec column = reader.column(K - 1, 2, 8);
+
+    for (uint i = 2; i < 8; ++i)
+    {
+        CHECK_EQUAL(mesh.storedEventValues()(i, K - 1), column(i - 2));
+    }
+
     for (SaveData* event : saveDataEvents)
     {
         mesh.removeEvent(event);
@@ -87,6 +175,1504 @@ TEST(saveAndLoad)
 
 }
 
+TEST(legacyStorage)
+{
+    //Pre-versioned layout: names, planned nRows and nCols, then rows. The
+    //names line leaves the values off 8 byte alignment.
+    const string path = "/tmp/ignis_test_legacy.ign";
+
+    const uint nRows = 7;
+    const uint nCols = 3;
+
+    ofstream file(path, ios::binary);
+    file << "a bb c\n";
+    file.write(reinterpret_cast<const char*>(&nRows), sizeof(uint));
+    file.write(reinterpret_cast<const char*>(&nCols), sizeof(uint));
+
+    for (uint i = 0; i < nRows; ++i)
+    {
+        for (uint j = 0; j < nCols; ++j)
+        {
+            const double value = 10*i + j + 0.5;
+            file.write(reinterpret_cast<const char*>(&value), sizeof(double));
+        }
+    }
+
+    file.close();
+
+    IgnReader reader(path);
+
+    CHECK_EQUAL(0, reader.header().m_version);
+    CHECK_EQUAL(nRows, reader.nRows());
+    CHECK_EQUAL(nCols, reader.nCols());
+    CHECK_EQUAL(42.5, reader(4, 2));
+    CHECK_EQUAL(61.5, reader.column(1)(6));
+    CHECK_EQUAL(30.5, reader.rows(2, 5)(1, 0));
+
+    uint nVisited = 0;
+
+    reader.forEachBlock(3, [&] (const uint first, const mat &block)
+    {
+        for (uint i = 0; i < block.n_cols; ++i)
+        {
+            CHECK_EQUAL(10*(first + i) + 2.5, block(2, i));
+            nVisited++;
+        }
+    });
+
+    CHECK_EQUAL(nRows, nVisited);
+
+    remove(path.c_str());
+}
+
+TEST(ignHeaderValidation)
+{
+    IgnHeader header;
+    header.m_columnNames = {"a", "b"};
+    header.m_units = {"m", "s"};
+
+    const string valid = header.serialize();
+
+    IgnHeader parsed;
+    CHECK(parsed.parse(valid.data(), valid.size(), "valid.ign"));
+    CHECK_EQUAL(2, parsed.nCols());
+    CHECK(!parsed.parse("NOPE", 4));
+
+    auto corrupted = [&valid] (const uint offset, const uint32_t value)
+    {
+        string bytes = valid;
+        memcpy(&bytes[offset], &value, sizeof(uint32_t));
+        return bytes;
+    };
+
+    //Version, endianness, dtype and data offset.
+    for (const string &bytes : {corrupted(4, 2), corrupted(8, 0x04030201), corrupted(12, 2), corrupted(36, 4)})
+    {
+        CHECK_THROW(parsed.parse(bytes.data(), bytes.size(), "corrupt.ign"), std::runtime_error);
+    }
+
+    //Truncated inside the fixed fields and inside the column names.
+    for (const uint size : {20u, (uint)IgnHeader::fixedSize + 6})
+    {
+        CHECK_THROW(parsed.parse(valid.data(), size, "truncated.ign"), std::runtime_error);
+    }
+
+    try
+    {
+        const string bytes = corrupted(4, 2);
+        parsed.parse(bytes.data(), bytes.size(), "corrupt.ign");
+    }
+
+    catch (const std::runtime_error &error)
+    {
+        CHECK(string(error.what()).find("corrupt.ign") != string::npos);
+        CHECK(string(error.what()).find("version") != string::npos);
+    }
+}
+
+TEST(ignReaderValidation)
+{
+    const string path = "/tmp/ignis_test_invalid.ign";
+
+    auto writeFile = [&path] (const string &bytes)
+    {
+        ofstream file(path, ios::binary);
+        file.write(bytes.data(), bytes.size());
+    };
+
+    CHECK_THROW(IgnReader("/tmp/ignis_test_missing/none.ign"), std::runtime_error);
+
+    writeFile("");
+    CHECK_THROW(IgnReader reader(path), std::runtime_error);
+
+    writeFile("no newline");
+    CHECK_THROW(IgnReader reader(path), std::runtime_error);
+
+    IgnHeader header;
+    header.m_columnNames = {"a"};
+    header.m_units = {""};
+    header.m_nRows = 4;
+
+    //Three of the four stated rows.
+    writeFile(header.serialize() + string(3*sizeof(double), '\0'));
+    CHECK_THROW(IgnReader reader(path), std::runtime_error);
+
+    writeFile(header.serialize() + string(4*sizeof(double), '\0'));
+    CHECK_EQUAL(4, IgnReader(path).nRows());
+
+    //A compressed file whose block index lies past the end.
+    header.m_flags |= IgnHeader::Compressed;
+    header.m_indexOffset = 1 << 20;
+
+    writeFile(header.serialize());
+    CHECK_THROW(IgnReader reader(path), std::runtime_error);
+
+    remove(path.c_str());
+}
+
+TEST(eventGraph)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    mat results[2];
+
+    for (uint run = 0; run < 2; ++run)
+    {
+        Mesh mesh = {10, 10 , 10};
+
+        mesh.enableOutput(false);
+        mesh.enableEventValueStorage(true, false);
+        mesh.setEventThreads(run == 0 ? 1 : 4);
+
+        vector<ChainedValue*> events;
+        for (uint chain = 0; chain < 4; ++chain)
+        {
+            ChainedValue *previous = nullptr;
+
+            for (uint k = 0; k < 3; ++k)
+            {
+                events.push_back(new ChainedValue(chain + 0.1*k, previous));
+                mesh.addEvent(events.back());
+
+                previous = events.back();
+            }
+        }
+
+        mesh.eventLoop(20);
+
+        results[run] = mesh.storedEventValues();
+
+        for (ChainedValue *event : events)
+        {
+            mesh.removeEvent(event);
+            delete event;
+        }
+    }
+
+    CHECK_EQUAL(results[0].n_rows, results[1].n_rows);
+
+    for (uint i = 0; i < results[0].n_rows; ++i)
+    {
+        for (uint k = 0; k < results[0].n_cols; ++k)
+        {
+            CHECK_EQUAL(results[0](i, k), results[1](i, k));
+        }
+    }
+
+    CHECK_CLOSE((3 + 3.1 + 3.2)*19, results[1](19, 11), 1E-10);
+
+}
+
+TEST(executionPlan)
+{
+    class CountResets : public MeshEvent
+    {
+    public:
+
+        uint m_nResets = 0;
+
+        void execute() {}
+
+        void reset()
+        {
+            MeshEvent::reset();
+            m_nResets++;
+        }
+    };
+
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(false);
+
+    bool cyclesMatch = true;
+
+    BasicExecuteEvent<double> *late = new BasicExecuteEvent<double>("late", [&] (BasicExecuteEvent<double> *event)
+    {
+        cyclesMatch = cyclesMatch && (event->cycle() + 5 == event->loopCycle());
+    });
+
+    late->setOnsetTime(5);
+
+    CountResets *counter = new CountResets();
+
+    mesh.addEvent(late);
+    mesh.addEvent(counter);
+
+    mesh.eventLoop(20);
+
+    CHECK(cyclesMatch);
+    CHECK_EQUAL(20, counter->m_nResets);
+    CHECK(late->resetFree());
+    CHECK(!counter->resetFree());
+
+    mesh.removeEvent(late);
+    mesh.removeEvent(counter);
+
+    delete late;
+    delete counter;
+
+}
+
+TEST(periodicEvents)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(false);
+    mesh.enableEventValueStorage(true, false, "ignisEventsOut.ign", "/tmp", 3);
+
+    vector<uint> cycles;
+    vector<string> order;
+
+    BasicExecuteEvent<double> *first = new BasicExecuteEvent<double>("first", [&] (BasicExecuteEvent<double> *event)
+    {
+        (void)event;
+        order.push_back("first");
+    });
+
+    BasicExecuteEvent<double> *periodic = new BasicExecuteEvent<double>("periodic", [&] (BasicExecuteEvent<double> *event)
+    {
+        cycles.push_back(event->loopCycle());
+        order.push_back("periodic");
+    });
+
+    BasicExecuteEvent<double> *last = new BasicExecuteEvent<double>("last", [&] (BasicExecuteEvent<double> *event)
+    {
+        (void)event;
+        order.push_back("last");
+    });
+
+    periodic->setPeriod(4, 2);
+    periodic->setOnsetTime(3);
+
+    SaveData *saveData = new SaveData(1);
+
+    mesh.addEvent(first);
+    mesh.addEvent(periodic);
+    mesh.addEvent(last);
+    mesh.addEvent(saveData);
+
+    uint nCycles = 20;
+    mesh.eventLoop(nCycles);
+
+    CHECK_EQUAL(4, cycles.size());
+
+    for (uint k = 0; k < cycles.size(); ++k)
+    {
+        CHECK_EQUAL(6 + 4*k, cycles.at(k));
+    }
+
+    //The periodic event keeps its priority among the others on the cycles it runs.
+    CHECK_EQUAL(2*nCycles + cycles.size(), order.size());
+    CHECK_EQUAL("periodic", order.at(2*6 + 1));
+
+    CHECK_EQUAL(7, mesh.storedEventValues().n_rows);
+
+    for (uint i = 0; i < mesh.storedEventValues().n_rows; ++i)
+    {
+        CHECK_EQUAL(3*i, mesh.storedEventValues()(i, 0));
+    }
+
+    for (Event<double> *event : vector<Event<double>*>{first, periodic, last, saveData})
+    {
+        mesh.removeEvent(event);
+        delete event;
+    }
+
+}
+
+TEST(chunkSetup)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(false);
+
+    const uint nCycles = 50;
+
+    vector<BasicExecuteEvent<double>*> events;
+    vector<uint> counts(40, 0);
+    bool inside = true;
+
+    for (uint k = 0; k < counts.size(); ++k)
+    {
+        events.push_back(new BasicExecuteEvent<double>("interval", [&, k] (BasicExecuteEvent<double> *event)
+        {
+            counts[k]++;
+            inside = inside && event->loopCycle() >= event->onsetTime() && event->loopCycle() <= event->offsetTime();
+        }));
+
+        const uint onset = (7*k)%nCycles;
+
+        if (k%2 == 0)
+        {
+            events.back()->setTrigger(onset);
+        }
+
+        else
+        {
+            events.back()->setOnsetTime(onset);
+            events.back()->setOffsetTime(std::min(nCycles - 1, onset + k));
+        }
+
+        mesh.addEvent(events.back());
+    }
+
+    mesh.eventLoop(nCycles);
+
+    CHECK(inside);
+
+    for (uint k = 0; k < counts.size(); ++k)
+    {
+        const uint onset = (7*k)%nCycles;
+
+        CHECK_EQUAL(k%2 == 0 ? 1 : std::min(nCycles - 1, onset + k) - onset + 1, counts[k]);
+    }
+
+    for (uint k = events.size(); k-- > 0;)
+    {
+        mesh.removeEvent(events[k]);
+        delete events[k];
+    }
+
+}
+
+TEST(runtimeEvents)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(false);
+
+    vector<uint> measured;
+    uint nRetiredCalls = 0;
+
+    BasicExecuteEvent<double> *measurement = new BasicExecuteEvent<double>("measurement", [&] (BasicExecuteEvent<double> *event)
+    {
+        measured.push_back(event->loopCycle());
+    });
+
+    BasicExecuteEvent<double> *retired = new BasicExecuteEvent<double>("retired", [&] (BasicExecuteEvent<double> *event)
+    {
+        (void)event;
+        nRetiredCalls++;
+    });
+
+    BasicExecuteEvent<double> *spawner = new BasicExecuteEvent<double>("spawner", [&] (BasicExecuteEvent<double> *event)
+    {
+        if (event->loopCycle() == 5)
+        {
+            mesh.insertEvent(measurement, 2, 3);
+        }
+
+        else if (event->loopCycle() == 12)
+        {
+            mesh.retireEvent(retired);
+        }
+    });
+
+    mesh.addEvent(spawner);
+    mesh.addEvent(retired);
+
+    mesh.eventLoop(20);
+
+    CHECK_EQUAL(3, measured.size());
+
+    for (uint k = 0; k < measured.size(); ++k)
+    {
+        CHECK_EQUAL(8 + k, measured.at(k));
+    }
+
+    CHECK_EQUAL(13, nRetiredCalls);
+
+    mesh.removeEvent(spawner);
+    mesh.removeEvent(measurement);
+
+    delete spawner;
+    delete measurement;
+    delete retired;
+
+}
+
+TEST(spatialIndex)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    auto box = [] (const double low, const double high)
+    {
+        mat topology(IGNIS_DIM, 2);
+        topology.col(0).fill(low);
+        topology.col(1).fill(high);
+        return topology;
+    };
+
+    for (uint i = 0; i < system.count(); ++i)
+    {
+        for (uint j = 0; j < IGNIS_DIM; ++j)
+        {
+            system(i, j) = 0.33*i + 0.1*j;
+        }
+    }
+
+    Mesh mesh(box(0, 10));
+    mesh.enableOutput(false);
+
+    meshfield outer(box(1, 7), "outer");
+    meshfield inner(box(2, 4), "inner");
+    meshfield other(box(7.5, 9.5), "other");
+
+    outer.addSubField(inner);
+    mesh.addSubField(outer);
+    mesh.addSubField(other);
+
+    mesh.eventLoop(1);
+
+    const vector<uint> outerAtoms = outer.getAtoms();
+    const vector<uint> innerAtoms = inner.getAtoms();
+    const vector<uint> otherAtoms = other.getAtoms();
+
+    mesh.enableSpatialIndex(true, 4);
+    mesh.eventLoop(1);
+
+    CHECK(outerAtoms == outer.getAtoms());
+    CHECK(innerAtoms == inner.getAtoms());
+    CHECK(otherAtoms == other.getAtoms());
+
+    mesh.setContainmentThreads(4);
+    mesh.eventLoop(1);
+
+    CHECK(outerAtoms == outer.getAtoms());
+    CHECK(innerAtoms == inner.getAtoms());
+    CHECK(otherAtoms == other.getAtoms());
+
+    mesh.enableSpatialIndex(false);
+    mesh.eventLoop(1);
+
+    CHECK(outerAtoms == outer.getAtoms());
+    CHECK(innerAtoms == inner.getAtoms());
+    CHECK(otherAtoms == other.getAtoms());
+
+}
+
+TEST(incrementalContainment)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    auto box = [] (const double low, const double high)
+    {
+        mat topology(IGNIS_DIM, 2);
+        topology.col(0).fill(low);
+        topology.col(1).fill(high);
+        return topology;
+    };
+
+    auto reset = [&system] ()
+    {
+        for (uint i = 0; i < system.count(); ++i)
+        {
+            for (uint j = 0; j < IGNIS_DIM; ++j)
+            {
+                system(i, j) = 0.33*i + 0.1*j;
+            }
+        }
+    };
+
+    Mesh mesh(box(0, 10));
+    mesh.enableOutput(false);
+
+    meshfield outer(box(1, 7), "outer");
+    meshfield inner(box(2, 4), "inner");
+    meshfield other(box(7.5, 9.5), "other");
+
+    outer.addSubField(inner);
+    mesh.addSubField(outer);
+    mesh.addSubField(other);
+
+    BasicExecuteEvent<double> mover("mover", [&system] (BasicExecuteEvent<double> *event)
+    {
+        for (uint i = 0; i < system.count(); ++i)
+        {
+            system(i, i%IGNIS_DIM) += 0.4*((event->cycle() + i)%3) - 0.3;
+        }
+    });
+
+    mesh.addEvent(mover);
+
+    auto sorted = [] (vector<uint> atoms)
+    {
+        sort(atoms.begin(), atoms.end());
+        return atoms;
+    };
+
+    reset();
+    mesh.eventLoop(20);
+
+    const vector<uint> outerAtoms = outer.getAtoms();
+    const vector<uint> innerAtoms = inner.getAtoms();
+    const vector<uint> otherAtoms = other.getAtoms();
+
+    reset();
+    mesh.enableIncrementalContainment(true);
+    mesh.eventLoop(20);
+
+    CHECK(outerAtoms == sorted(outer.getAtoms()));
+    CHECK(innerAtoms == sorted(inner.getAtoms()));
+    CHECK(otherAtoms == sorted(other.getAtoms()));
+
+    //Overlapping siblings fall back to the full pass, which fills both.
+    meshfield overlapping(box(5, 9), "overlapping");
+    mesh.addSubField(overlapping);
+
+    reset();
+    mesh.enableIncrementalContainment(false);
+    mesh.eventLoop(20);
+
+    const vector<uint> overlappingAtoms = overlapping.getAtoms();
+    const vector<uint> fullOuterAtoms = outer.getAtoms();
+
+    reset();
+    mesh.enableIncrementalContainment(true);
+    mesh.eventLoop(20);
+
+    CHECK(!overlappingAtoms.empty());
+    CHECK(overlappingAtoms == overlapping.getAtoms());
+    CHECK(fullOuterAtoms == outer.getAtoms());
+
+}
+
+TEST(positionSpan)
+{
+    TestSystem system;
+    ContiguousTestSystem contiguousSystem;
+
+    for (uint i = 0; i < system.count(); ++i)
+    {
+        for (uint j = 0; j < IGNIS_DIM; ++j)
+        {
+            system(i, j) = contiguousSystem(i, j) = 0.9*i - 8.0 + j;
+        }
+    }
+
+    for (PositionHandler<double> *handler : {(PositionHandler<double>*)&system, (PositionHandler<double>*)&contiguousSystem})
+    {
+        Mesh::setCurrentParticles(handler);
+
+        mat topology(IGNIS_DIM, 2);
+        topology.col(0).fill(0);
+        topology.col(1).fill(10);
+
+        Mesh mesh(topology);
+        mesh.enableOutput(false);
+
+        periodicScaling<double> periodic;
+        mesh.addEvent(periodic);
+
+        mesh.eventLoop(1);
+    }
+
+    for (uint i = 0; i < system.count(); ++i)
+    {
+        for (uint j = 0; j < IGNIS_DIM; ++j)
+        {
+            CHECK_EQUAL(system(i, j), contiguousSystem(i, j));
+            CHECK(system(i, j) >= 0 && system(i, j) <= 10);
+        }
+    }
+
+}
+
+TEST(positionView)
+{
+    TestSystem system;
+    ContiguousTestSystem contiguousSystem;
+
+    for (PositionHandler<double> *handler : {(PositionHandler<double>*)&system, (PositionHandler<double>*)&contiguousSystem})
+    {
+        for (uint i = 0; i < handler->count(); ++i)
+        {
+            for (uint j = 0; j < IGNIS_DIM; ++j)
+            {
+                (*handler)(i, j) = i + 0.1*j;
+            }
+        }
+
+        //Writes go straight to the handler's storage.
+        PositionView<double, IGNIS_DIM> view = handler->vec(3);
+
+        view *= 2;
+        view(0) = -1;
+
+        CHECK_EQUAL(3, view.index());
+        CHECK_EQUAL(-1, (*handler)(3, 0));
+
+        for (uint j = 1; j < IGNIS_DIM; ++j)
+        {
+            CHECK_CLOSE(2*(3 + 0.1*j), (*handler)(3, j), 1E-12);
+        }
+
+        vec::fixed<IGNIS_DIM> shift;
+        shift.fill(0.5);
+
+        handler->vec(4) += shift;
+
+        const PositionHandler<double> &constHandler = *handler;
+        const vec::fixed<IGNIS_DIM> read = constHandler.vec(4);
+
+        for (uint j = 0; j < IGNIS_DIM; ++j)
+        {
+            CHECK_CLOSE(4.5 + 0.1*j, read(j), 1E-12);
+            CHECK_EQUAL((*handler)(4, j), read(j));
+        }
+    }
+
+    //VolumeChange scales the particles themselves, not a copy.
+    const double ratio = 8;
+    const double scale = std::pow(ratio, 1.0/IGNIS_DIM);
+
+    Mesh::setCurrentParticles(system);
+
+    for (uint i = 0; i < system.count(); ++i)
+    {
+        for (uint j = 0; j < IGNIS_DIM; ++j)
+        {
+            system(i, j) = 0.3*i + 0.1*j;
+        }
+    }
+
+    const mat before = system;
+
+    mat topology(IGNIS_DIM, 2);
+    topology.col(0).fill(0);
+    topology.col(1).fill(10);
+
+    Mesh mesh(topology);
+    mesh.enableOutput(false);
+
+    VolumeChange<double> expansion(ratio, false);
+    mesh.addEvent(expansion);
+
+    mesh.eventLoop(10);
+
+    CHECK_CLOSE(ratio*std::pow(10.0, IGNIS_DIM), mesh.volume, 1E-8);
+
+    for (uint i = 0; i < system.count(); ++i)
+    {
+        for (uint j = 0; j < IGNIS_DIM; ++j)
+        {
+            CHECK_CLOSE(scale*before(i, j), system(i, j), 1E-10);
+        }
+    }
+
+    mesh.removeEvent(&expansion);
+}
+
+TEST(boxKernel)
+{
+    const uint N = 203;
+
+    vector<double> aos(N*IGNIS_DIM);
+    vector<float> soa(N*IGNIS_DIM);
+
+    for (uint i = 0; i < N; ++i)
+    {
+        for (uint d = 0; d < IGNIS_DIM; ++d)
+        {
+            aos[i*IGNIS_DIM + d] = soa[d*N + i] = fmod(0.731*i*(d + 1), 3.0);
+        }
+    }
+
+    const double low[] = {0.5, 0.25, 1.0};
+    const double high[] = {2.5, 2.0, 2.75};
+    const float lowf[] = {0.5, 0.25, 1.0};
+    const float highf[] = {2.5, 2.0, 2.75};
+
+    const PositionSpan<double> aosSpan = PositionSpan<double>::AoS(aos.data());
+    const PositionSpan<float> soaSpan = PositionSpan<float>::SoA(soa.data(), N);
+
+    vector<uint> expected, aosIndices, soaIndices;
+
+    for (uint i = 3; i < N; ++i)
+    {
+        if (boxMaskScalar(aosSpan, low, high, i, 1))
+        {
+            expected.push_back(i);
+        }
+    }
+
+    boxContainment(aosSpan, low, high, 3, N, aosIndices);
+    boxContainment(soaSpan, lowf, highf, 3, N, soaIndices);
+
+    CHECK(!expected.empty());
+    CHECK(expected == aosIndices);
+    CHECK(expected == soaIndices);
+
+}
+
+TEST(profiling)
+{
+    typedef EventProfiler<double>::Timing Timing;
+
+    Timing timing;
+
+    for (uint ns = 1; ns <= 1000; ++ns)
+    {
+        timing.add(ns);
+    }
+
+    CHECK_EQUAL(1000, timing.m_calls);
+    CHECK_EQUAL(1, timing.m_minNs);
+    CHECK_EQUAL(1000, timing.m_maxNs);
+
+    const uint64_t p99 = timing.quantile(0.99);
+
+    CHECK(p99 >= 990);
+    CHECK(p99 <= 1000);
+
+    for (uint64_t ns = 4; ns < 100000; ns = ns*3/2)
+    {
+        CHECK(Timing::binUpperEdge(Timing::bin(ns)) >= ns);
+        CHECK(Timing::binUpperEdge(Timing::bin(ns)) < ns*1.25);
+    }
+
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(false);
+    mesh.enableProfiling(true, "ignis_test_profile");
+
+    BasicExecuteEvent<double> *event = new BasicExecuteEvent<double>("profiled", [] (BasicExecuteEvent<double> *event)
+    {
+        (void)event;
+    });
+
+    mesh.addEvent(event);
+
+    const uint nCycles = 50;
+    mesh.eventLoop(nCycles);
+
+    const string path = mesh.outputPath() + "ignis_test_profile";
+
+    ifstream json(path + ".json");
+    CHECK(json.good());
+
+    ifstream csv(path + ".csv");
+    CHECK(csv.good());
+
+    string line;
+    uint nCalls = 0;
+    bool containment = false;
+
+    while (getline(csv, line))
+    {
+        if (line.find("profiled") != string::npos && line.find("execute") != string::npos)
+        {
+            nCalls = atoi(line.substr(line.find("execute,") + 8).c_str());
+        }
+
+        if (line.find("containment\",update") != string::npos)
+        {
+            containment = true;
+        }
+    }
+
+    CHECK_EQUAL(nCycles, nCalls);
+    CHECK(containment);
+
+    mesh.enableProfiling(false);
+    mesh.removeEvent(event);
+
+    delete event;
+
+    remove((path + ".json").c_str());
+    remove((path + ".csv").c_str());
+}
+
+TEST(tracing)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(false);
+    mesh.enableEventValueStorage(true, true, "ignis_test_trace.ign");
+    mesh.setEventStorageBuffering(4, 2, true);
+    mesh.enableTracing(true, 2, 1 << 10, "ignis_test_trace");
+
+    SaveData *event = new SaveData(1);
+
+    mesh.addEvent(event);
+
+    const uint nCycles = 10;
+    mesh.eventLoop(nCycles);
+
+    const string path = mesh.outputPath() + "ignis_test_trace";
+
+    ifstream json(path + ".json");
+    CHECK(json.good());
+
+    string line;
+    uint nExecuted = 0;
+    uint nWrites = 0;
+    bool chunk = false;
+
+    while (getline(json, line))
+    {
+        if (line.find("SaveData") != string::npos && line.find("\"execute\"") != string::npos)
+        {
+            nExecuted++;
+        }
+
+        if (line.find("\"write\"") != string::npos)
+        {
+            nWrites++;
+        }
+
+        if (line.find("chunk [0, 9]") != string::npos)
+        {
+            chunk = true;
+        }
+    }
+
+    CHECK_EQUAL(nCycles/2, nExecuted);
+    CHECK(nWrites != 0);
+    CHECK(chunk);
+
+    mesh.enableTracing(false);
+    mesh.removeEvent(event);
+
+    delete event;
+
+    remove((path + ".json").c_str());
+    remove((mesh.outputPath() + "ignis_test_trace.ign").c_str());
+}
+
+TEST(dependencyHandles)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(false);
+
+    ChainedValue first(1);
+    ChainedValue second(2, &first);
+
+    BasicExecuteEvent<double> reader("reader", [] (BasicExecuteEvent<double> *event)
+    {
+        (void)event;
+    });
+
+    const DependencyHandle<ChainedValue> handle = reader.setDependency(first);
+    CHECK(handle.valid());
+    CHECK_EQUAL(&first, reader.dependency(handle));
+
+    //Replacing a dependency of the same type moves existing handles along.
+    const DependencyHandle<ChainedValue> replaced = reader.setDependency(second);
+    CHECK_EQUAL(&second, reader.dependency(handle));
+    CHECK_EQUAL(&second, reader.dependency(replaced));
+    CHECK_EQUAL(reader.dependency("ChainedValue"), reader.dependency(handle));
+
+    mesh.addEvent(first);
+    mesh.addEvent(second);
+    mesh.addEvent(reader);
+
+    const uint nCycles = 10;
+    mesh.eventLoop(nCycles);
+
+    CHECK_EQUAL(&second, reader.dependency(handle));
+    CHECK_CLOSE((1 + 2)*(nCycles - 1), second.value(), 1E-10);
+
+    mesh.removeEvent(&reader);
+    mesh.removeEvent(&second);
+    mesh.removeEvent(&first);
+}
+
+TEST(eventOrdering)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    auto box = [] (const double low, const double high)
+    {
+        mat topology(IGNIS_DIM, 2);
+        topology.col(0).fill(low);
+        topology.col(1).fill(high);
+        return topology;
+    };
+
+    Mesh mesh(box(0, 10));
+    mesh.enableOutput(false);
+
+    meshfield left(box(0, 4), "left");
+    meshfield right(box(5, 9), "right");
+
+    mesh.addSubField(left);
+    mesh.addSubField(right);
+
+    vector<string> order;
+
+    auto recorder = [&order] (BasicExecuteEvent<double> *event)
+    {
+        order.push_back(event->type());
+    };
+
+    BasicExecuteEvent<double> a("a", recorder);
+    BasicExecuteEvent<double> b("b", recorder);
+    BasicExecuteEvent<double> c("c", recorder);
+    BasicExecuteEvent<double> d("d", recorder);
+
+    left.addEvent(a);
+    right.addEvent(b);
+    left.addEvent(c);
+    right.addEvent(d);
+
+    //Alternate between the fields.
+    a.setManualPriority(100);
+    b.setManualPriority(101);
+    c.setManualPriority(102);
+    d.setManualPriority(103);
+
+    mesh.eventLoop(1);
+
+    CHECK((order == vector<string>{"a", "b", "c", "d"}));
+
+    //Undeclared events are never moved past each other.
+    order.clear();
+    mesh.enableFieldGrouping();
+    mesh.eventLoop(1);
+
+    CHECK((order == vector<string>{"a", "b", "c", "d"}));
+
+    for (BasicExecuteEvent<double> *event : {&a, &b, &c, &d})
+    {
+        event->declareAccess(0, 0);
+    }
+
+    order.clear();
+    mesh.eventLoop(1);
+
+    CHECK((order == vector<string>{"a", "c", "b", "d"}));
+
+    //Created first, but runs after what it depends on.
+    a.setDependency(c);
+
+    order.clear();
+    mesh.enableFieldGrouping(false);
+    mesh.eventLoop(1);
+
+    CHECK((order == vector<string>{"b", "c", "a", "d"}));
+
+    order.clear();
+    mesh.enableFieldGrouping();
+    mesh.eventLoop(1);
+
+    CHECK((order == vector<string>{"b", "d", "c", "a"}));
+
+    c.setDependency(a);
+
+    CHECK_THROW(mesh.eventLoop(1), std::logic_error);
+
+    mesh.finalize();
+
+    left.removeEvent(&a);
+    right.removeEvent(&b);
+    left.removeEvent(&c);
+    right.removeEvent(&d);
+}
+
+TEST(asyncOutput)
+{
+    SpscQueue<uint> queue(3);
+
+    CHECK_EQUAL(4, queue.capacity());
+
+    uint item = 0;
+    CHECK(!queue.pop(item));
+
+    for (uint i = 0; i < 4; ++i)
+    {
+        CHECK(queue.push(i));
+    }
+
+    CHECK(!queue.push(4));
+
+    CHECK(queue.pop(item));
+    CHECK_EQUAL(0, item);
+
+    const uint nItems = 100000;
+    uint64_t sum = 0;
+
+    std::thread consumer([&] ()
+    {
+        uint value;
+
+        for (uint i = 0; i < 3 + nItems;)
+        {
+            if (queue.pop(value))
+            {
+                sum += value;
+                ++i;
+            }
+
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (uint i = 0; i < nItems; ++i)
+    {
+        while (!queue.push(i))
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    consumer.join();
+
+    CHECK_EQUAL(1 + 2 + 3 + uint64_t(nItems)*(nItems - 1)/2, sum);
+
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(true, 3);
+
+    OutputValue first(0.5);
+    OutputValue second(2);
+
+    mesh.addEvent(first);
+    mesh.addEvent(second);
+
+    const uint nCycles = 20;
+
+    stringstream synchronous;
+    streambuf *stdout = cout.rdbuf(synchronous.rdbuf());
+
+    mesh.eventLoop(nCycles);
+
+    cout.rdbuf(stdout);
+
+    stringstream asynchronous;
+
+    //A small queue makes the loop wait for the formatter.
+    mesh.enableAsyncOutput(true, 2, asynchronous);
+    mesh.eventLoop(nCycles);
+
+    //The synchronous run also printed the loop chunks.
+    auto eventLines = [] (stringstream &output)
+    {
+        string lines, line;
+
+        while (getline(output, line))
+        {
+            if (line.empty() || line[0] == '<')
+            {
+                lines += line + "\n";
+            }
+        }
+
+        return lines;
+    };
+
+    const string expected = eventLines(synchronous);
+
+    CHECK(expected.find("value: 36 m >") != string::npos);
+    CHECK_EQUAL(expected, eventLines(asynchronous));
+
+    mesh.enableAsyncOutput(false);
+
+    mesh.removeEvent(&first);
+    mesh.removeEvent(&second);
+}
+
+TEST(eventValues)
+{
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    Mesh mesh = {10, 10 , 10};
+
+    mesh.enableOutput(false);
+    mesh.enableEventValueStorage(true, false, "ignisEventsOut.ign", "/tmp", 2);
+
+    SaveData first(1);
+    SaveData second(2);
+    OutputValue unstored(3);
+
+    bool contiguous = true;
+
+    BasicExecuteEvent<double> check("check", [&] (BasicExecuteEvent<double> *event)
+    {
+        (void)event;
+
+        //Stored values form one row in column order while the loop runs.
+        contiguous = contiguous && (&first.value() + 1 == &second.value());
+    });
+
+    mesh.addEvent(first);
+    mesh.addEvent(second);
+    mesh.addEvent(unstored);
+    mesh.addEvent(check);
+
+    const uint nCycles = 10;
+    mesh.eventLoop(nCycles);
+
+    CHECK(contiguous);
+
+    CHECK_EQUAL(nCycles/2, mesh.storedEventValues().n_rows);
+
+    for (uint i = 0; i < mesh.storedEventValues().n_rows; ++i)
+    {
+        CHECK_EQUAL(2*i, mesh.storedEventValues()(i, 0));
+        CHECK_EQUAL(4*i, mesh.storedEventValues()(i, 1));
+    }
+
+    //The values are handed back to the events when the loop is finalized.
+    CHECK_EQUAL(nCycles - 1, first.value());
+    CHECK_EQUAL(2*(nCycles - 1), second.value());
+    CHECK_EQUAL(3*(nCycles - 2), unstored.value());
+    CHECK(&first.value() + 1 != &second.value());
+
+    first.setValue(-1);
+    CHECK_EQUAL(-1, first.value());
+
+    mesh.removeEvent(&first);
+    mesh.removeEvent(&second);
+    mesh.removeEvent(&unstored);
+    mesh.removeEvent(&check);
+}
+
+template<uint D>
+void checkDimension()
+{
+    const uint N = 40;
+
+    DimensionTestSystem<D> system(N);
+    MainMesh<double, D>::setCurrentParticles(system);
+
+    //Particle n sits at x = n/4, and at 1 in the other dimensions.
+    for (uint n = 0; n < N; ++n)
+    {
+        system(n, 0) = 0.25*n;
+
+        for (uint d = 1; d < D; ++d)
+        {
+            system(n, d) = 1;
+        }
+    }
+
+    //Wrapped back to 0.5 along the last dimension.
+    system(0, D - 1) = 10.5;
+
+    mat topology(D, 2);
+    topology.col(0).fill(0);
+    topology.col(1).fill(10);
+
+    MainMesh<double, D> mesh(topology);
+    mesh.enableOutput(false);
+
+    CHECK_EQUAL(std::pow(10.0, D), mesh.volume);
+
+    topology(0, 1) = 5;
+    MeshField<double, D> low(topology, "low");
+
+    mesh.addSubField(low);
+
+    periodicScaling<double, D> scaling;
+    countAtoms<double, D> count;
+    DimensionSum<D> sum;
+
+    mesh.addEvent(scaling);
+    low.addEvent(count);
+    mesh.addEvent(sum);
+
+    mesh.eventLoop(3);
+
+    CHECK_EQUAL(0.5, system(0, D - 1));
+
+    //The wrapped particle and N - 1 at 1 (or at n/4 for D = 1).
+    CHECK_CLOSE(D == 1 ? 0.5 + 0.25*N*(N - 1)/2 : 0.5 + (N - 1), sum.value(), 1E-10);
+
+    //x = 0, 0.25, ..., 5
+    CHECK_CLOSE(21.0/N, count.value(), 1E-10);
+
+    mesh.removeEvent(&scaling);
+    low.removeEvent(&count);
+    mesh.removeEvent(&sum);
+}
+
+TEST(dimensions)
+{
+    //Meshes of any dimension share one build.
+    checkDimension<1>();
+    checkDimension<2>();
+    checkDimension<3>();
+}
+
+TEST(periodicWrapping)
+{
+    typedef periodicScaling<double> Periodic;
+
+    CHECK_CLOSE(9.5, Periodic::wrapFloor(-0.5, 0, 10, 0.1), 1E-12);
+    CHECK_CLOSE(5.0, Periodic::wrapFloor(25, 0, 10, 0.1), 1E-12);
+    CHECK_CLOSE(2.5, Periodic::wrapFloor(12.5, 2, 10, 0.1), 1E-12);
+    CHECK_CLOSE(3.0, Periodic::wrapFloor(3, 0, 10, 0.1), 1E-12);
+
+    CHECK_EQUAL(0.5, Periodic::wrapBounded(10.5, 0, 10));
+    CHECK_EQUAL(9.5, Periodic::wrapBounded(-0.5, 0, 10));
+    CHECK_EQUAL(3.0, Periodic::wrapBounded(3, 0, 10));
+    CHECK_EQUAL(2.0, Periodic::wrapBounded(12, 2, 10));
+
+    const double step = 0.3;
+    const uint nCycles = 100;
+
+    vector<vector<double> > results;
+
+    for (const Periodic::Wrap wrap : {Periodic::Wrap::Floor, Periodic::Wrap::Bounded})
+    {
+        for (const bool faceTracking : {false, true})
+        {
+            ContiguousTestSystem system;
+            Mesh::setCurrentParticles(system);
+
+            for (uint i = 0; i < system.count(); ++i)
+            {
+                for (uint j = 0; j < IGNIS_DIM; ++j)
+                {
+                    system(i, j) = fmod(0.37*i + j, 10.0);
+                }
+            }
+
+            mat topology(IGNIS_DIM, 2);
+            topology.col(0).fill(0);
+            topology.col(1).fill(10);
+
+            Mesh mesh(topology);
+            mesh.enableOutput(false);
+
+            bool inside = true;
+
+            BasicExecuteEvent<double> move("move", [&] (BasicExecuteEvent<double> *event)
+            {
+                (void)event;
+
+                for (uint i = 0; i < system.count(); ++i)
+                {
+                    for (uint j = 0; j < IGNIS_DIM; ++j)
+                    {
+                        inside = inside && system(i, j) >= 0 && system(i, j) <= 10;
+
+                        //Particles cross the upper faces forwards and the lower ones backwards.
+                        system(i, j) += (i%2 == 0 ? step : -step);
+                    }
+                }
+            });
+
+            Periodic periodic(wrap);
+
+            mesh.addEvent(move);
+            mesh.addEvent(periodic);
+
+            //Overlaps neither the margin nor, with incremental containment, a sibling.
+            mat halfTopology = topology;
+            halfTopology(0, 1) = 5;
+
+            meshfield half(halfTopology, "half");
+            mesh.addSubField(half);
+
+            if (faceTracking)
+            {
+                periodic.enableFaceTracking(2*step);
+                CHECK(periodic.tracksFaces());
+
+                mesh.enableIncrementalContainment(true, 1.0);
+            }
+
+            mesh.eventLoop(nCycles);
+
+            CHECK(inside);
+
+            //The interior particles were skipped, and the field tree is untouched.
+            CHECK(!faceTracking || periodic.nearFace().size() < system.count()/2);
+            CHECK_EQUAL(1, mesh.getSubfields().size());
+
+            results.push_back({});
+
+            for (uint i = 0; i < system.count(); ++i)
+            {
+                for (uint j = 0; j < IGNIS_DIM; ++j)
+                {
+                    results.back().push_back(system(i, j));
+                }
+            }
+
+            mesh.removeEvent(&move);
+            mesh.removeEvent(&periodic);
+        }
+    }
+
+    for (uint k = 1; k < results.size(); ++k)
+    {
+        for (uint i = 0; i < results[0].size(); ++i)
+        {
+            CHECK_CLOSE(results[0][i], results[k][i], 1E-9);
+        }
+    }
+}
+
+TEST(randomStreams)
+{
+    //Known answers from the Random123 distribution.
+    const uint32_t counters[3][4] = {{0, 0, 0, 0},
+                                     {0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                                     {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344}};
+
+    const uint32_t keys[3][2] = {{0, 0}, {0xffffffff, 0xffffffff}, {0xa4093822, 0x299f31d0}};
+
+    const uint32_t expected[3][4] = {{0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8},
+                                     {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd},
+                                     {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}};
+
+    for (uint k = 0; k < 3; ++k)
+    {
+        uint32_t result[4];
+        RandomStream::philox(counters[k], keys[k], result);
+
+        for (uint j = 0; j < 4; ++j)
+        {
+            CHECK_EQUAL(expected[k][j], result[j]);
+        }
+    }
+
+    RandomStream stream(7, 3);
+
+    //Filled values match random access, whatever the offset and stride.
+    vector<double> values(2*11);
+    stream.fillUniform(values.data(), 5, 11, -1.0, 1.0, 2);
+
+    for (uint k = 0; k < 11; ++k)
+    {
+        CHECK_EQUAL(-1.0 + 2.0*stream.uniform(5 + k), values[2*k]);
+        CHECK(values[2*k] >= -1 && values[2*k] < 1);
+    }
+
+    stream.seek(5);
+    CHECK_EQUAL(stream.uniform(5), stream());
+    CHECK_EQUAL(stream.uniform(6), stream());
+
+    CHECK(stream.uniform(0) != RandomStream(8, 3).uniform(0));
+    CHECK(stream.uniform(0) != stream.substream(0).uniform(0));
+    CHECK(stream.substream(0).uniform(0) != stream.substream(1).uniform(0));
+
+    //Shuffled positions depend on the seed only, not on the storage or the thread count.
+    vector<vector<double> > results;
+
+    for (const uint64_t seed : {11, 11, 12})
+    {
+        for (const bool contiguous : {false, true})
+        {
+            TestSystem system;
+            ContiguousTestSystem contiguousSystem;
+
+            PositionHandler<double> &handler = contiguous ? (PositionHandler<double>&)contiguousSystem : system;
+            Mesh::setCurrentParticles(handler);
+
+            mat topology(IGNIS_DIM, 2);
+            topology.col(0).fill(-5);
+            topology.col(1).fill(10);
+
+            Mesh mesh(topology);
+            mesh.enableOutput(false);
+            mesh.setSeed(seed);
+
+            CHECK_EQUAL(seed, mesh.seed());
+
+            //An event run by another mesh shifts the priority of the shuffle, but not its stream.
+            BasicExecuteEvent<double> bystander("bystander", [] (BasicExecuteEvent<double> *event) {(void)event;});
+
+            if (!contiguous)
+            {
+                Mesh other(topology);
+                other.enableOutput(false);
+
+                other.addEvent(bystander);
+                other.eventLoop(1);
+                other.removeEvent(&bystander);
+            }
+
+            randomShuffle<double> shuffle;
+            shuffle.setThreads(contiguous ? 4 : 1);
+
+            mesh.addEvent(shuffle);
+            mesh.eventLoop(3);
+
+            results.push_back({});
+
+            for (uint i = 0; i < handler.count(); ++i)
+            {
+                for (uint j = 0; j < IGNIS_DIM; ++j)
+                {
+                    CHECK(handler(i, j) >= mesh.topology(j, 0) && handler(i, j) <= mesh.topology(j, 1));
+                    results.back().push_back(handler(i, j));
+                }
+            }
+
+            mesh.removeEvent(&shuffle);
+        }
+    }
+
+    CHECK(results[0] == results[1]);
+    CHECK(results[0] == results[2]);
+    CHECK(results[0] == results[3]);
+    CHECK(results[0] != results[4]);
+    CHECK(results[4] == results[5]);
+
+    //Events sharing a priority still draw from different streams.
+    TestSystem system;
+    Mesh::setCurrentParticles(system);
+
+    mat topology(IGNIS_DIM, 2);
+    topology.col(0).fill(0);
+    topology.col(1).fill(10);
+
+    Mesh mesh(topology);
+    mesh.enableOutput(false);
+
+    BasicExecuteEvent<double> first("first", [] (BasicExecuteEvent<double> *event) {(void)event;});
+    BasicExecuteEvent<double> second("second", [] (BasicExecuteEvent<double> *event) {(void)event;});
+
+    first.setManualPriority(7);
+    second.setManualPriority(7);
+
+    mesh.addEvent(first);
+    mesh.addEvent(second);
+    mesh.eventLoop(1);
+
+    CHECK(first.random().stream() != second.random().stream());
+
+    mesh.removeEvent(&first);
+    mesh.removeEvent(&second);
+}
+
 int main()
 {
     return UnitTest::RunAllTests();
@@ -33,4 +33,70 @@ public:
     }
 };
 
+class ContiguousTestSystem : public TestSystem
+{
+public:
+
+    PositionSpan<double> span()
+    {
+        return PositionSpan<double>::SoA(&data[0][0], count());
+    }
+
+    virtual double operator() (const uint n, const uint d) const
+    {
+        return data[d][n];
+    }
+
+    virtual double &operator() (const uint n, const uint d)
+    {
+        return data[d][n];
+    }
+
+private:
+
+    double data[IGNIS_DIM][30];
+
+};
+
+//! Contiguous positions for meshes of dimension D, which may differ from IGNIS_DIM.
+template<uint D>
+class DimensionTestSystem : public PositionHandler<double, D>
+{
+public:
+
+    DimensionTestSystem(const uint count) :
+        m_count(count),
+        m_data(count*D, 0)
+    {
+
+    }
+
+    PositionSpan<double, D> span()
+    {
+        return PositionSpan<double, D>::AoS(m_data.data());
+    }
+
+    virtual double operator() (const uint n, const uint d) const
+    {
+        return m_data[n*D + d];
+    }
+
+    virtual double &operator() (const uint n, const uint d)
+    {
+        return m_data[n*D + d];
+    }
+
+    uint count() const
+    {
+        return m_count;
+    }
+
+private:
+
+    const uint m_count;
+
+    std::vector<double> m_data;
+
+};
+
 }